@@ -0,0 +1,51 @@
+#include "matrix_accumulator.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+// Times Atomic against Sharded scatter-add for growing thread counts.
+// High contention hits a 4x4 target, low contention spreads over 256x256 cells.
+// Usage: accumulator_bench [adds per thread]
+
+static double runScatter(size_t side, size_t threadCount, size_t addsPerThread, AccumulationMode mode) {
+    DynamicMatrix target(side, side);
+    const auto start = std::chrono::steady_clock::now();
+
+    MatrixAccumulator accumulator(target, threadCount, mode);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < threadCount; ++t) {
+        threads.emplace_back([&accumulator, t, side, addsPerThread]() {
+            unsigned long long state = 0x9E3779B97F4A7C15ULL * (t + 1);
+            for (size_t n = 0; n < addsPerThread; ++n) {
+                state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+                const size_t cell = (state >> 33) % (side * side);
+                accumulator.add(t, cell / side, cell % side, Vector3D(1, 1, 1));
+            }
+        });
+    }
+    for (std::thread& thread : threads)
+        thread.join();
+    accumulator.merge();
+
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv) {
+    const size_t addsPerThread = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200000;
+    const size_t sides[] = {4, 256};
+    const char* names[] = {"high", "low"};
+
+    std::printf("hardware threads: %u, adds per thread: %zu\n", std::thread::hardware_concurrency(), addsPerThread);
+    std::printf("%-10s %8s %16s %16s\n", "contention", "threads", "atomic Madd/s", "sharded Madd/s");
+    for (size_t s = 0; s < 2; ++s) {
+        for (size_t threadCount = 1; threadCount <= 64; threadCount *= 2) {
+            const double adds = double(threadCount * addsPerThread) / 1e6;
+            const double atomic = runScatter(sides[s], threadCount, addsPerThread, AccumulationMode::Atomic);
+            const double sharded = runScatter(sides[s], threadCount, addsPerThread, AccumulationMode::Sharded);
+            std::printf("%-10s %8zu %16.1f %16.1f\n", names[s], threadCount, adds / atomic, adds / sharded);
+        }
+    }
+    return 0;
+}
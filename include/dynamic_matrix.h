@@ -2,20 +2,65 @@
 
 #include "vector3d_structure.h"
 #include <cstddef>
+#include <cstdint>
 #include <fstream>
 #include <stdexcept>
+#include <string>
+#include <vector>
+
+enum class MatrixLayout {
+    RowMajor,    // matrix[row][col]
+    ColumnMajor  // matrix[col][row]
+};
+
+// Sum, min and max of the cell lengths. Empty matrices reduce to all zeros.
+struct NormReduction {
+    double sum;
+    double min;
+    double max;
+};
 
 class DynamicMatrix {
 private:
     Vector3D** matrix;
     size_t rows;
     size_t cols;
+    MatrixLayout layout;
+    // One bit per checkpoint tile, set while the tile may differ from the last checkpoint
+    std::vector<uint64_t> dirtyTiles;
+    // Checksum of the base file saveDelta records are taken against, 0 until there is one
+    uint64_t checkpointBase = 0;
 
     void allocateMemory();
     void deallocateMemory();
 
+    // Storage is an array of outerSize() contiguous lines of innerSize() elements
+    size_t outerSize() const { return layout == MatrixLayout::RowMajor ? rows : cols; }
+    size_t innerSize() const { return layout == MatrixLayout::RowMajor ? cols : rows; }
+
+    Vector3D& cell(size_t row, size_t col) {
+        return layout == MatrixLayout::RowMajor ? matrix[row][col] : matrix[col][row];
+    }
+    const Vector3D& cell(size_t row, size_t col) const {
+        return layout == MatrixLayout::RowMajor ? matrix[row][col] : matrix[col][row];
+    }
+
+    void removeOuter(size_t index);
+    void removeInner(size_t index);
+    void insertOuter(size_t index, const Vector3D* values);
+    void insertInner(size_t index, const Vector3D* values);
+
+    size_t tileRowCount() const;
+    size_t tileColCount() const;
+    void markDirty(size_t row, size_t col);
+    void setAllDirtyBits() noexcept;
+    uint64_t contentChecksum() const;
+
+    template <typename Op>
+    static void elementwise(DynamicMatrix& result, const DynamicMatrix& lhs, const DynamicMatrix& rhs, Op op);
+
 public:
-    DynamicMatrix(size_t rows = 0, size_t cols = 0);
+    DynamicMatrix(size_t rows = 0, size_t cols = 0, MatrixLayout layout = MatrixLayout::RowMajor);
     ~DynamicMatrix();
 
     DynamicMatrix(const DynamicMatrix& other);
@@ -28,6 +73,15 @@ public:
     const Vector3D& at(size_t row, size_t col) const;
 
     double totalMagnitude() const;
+    // Compensated tree reduction over fixed tiles; the result is bitwise identical
+    // for any threadCount (0 picks one based on the hardware and matrix size).
+    // Parallel work runs on a shared pool that grows to threadCount - 1 helper threads
+    // (at most 63) and keeps them, so repeated calls (operator<) don't create threads;
+    // serial calls, including small matrices under the default, never start the pool.
+    // A call made while another reduction holds the pool runs serially.
+    NormReduction reduceNorms(size_t threadCount = 0) const;
+    // Helper threads currently in the shared reduction pool
+    static size_t reductionThreads();
 
     void deleteRow(size_t row);
     void deleteColumn(size_t col);
@@ -41,9 +95,38 @@ public:
     DynamicMatrix operator*(const DynamicMatrix& other) const;
     DynamicMatrix operator*(double scalar) const;
 
+    // Default leaf size for multiplyStrassen, picked with tuneStrassenCrossover
+    static const size_t defaultStrassenCrossover = 32;
+
+    // Strassen's recursive O(n^2.81) product of two square matrices, same semantics as
+    // operator*. Blocks at or below the crossover size (and non-square operands) use the
+    // classic kernel. The seven top-level sub-products run on up to threadCount threads
+    // (0 = hardware concurrency); deeper levels reuse one preallocated workspace.
+    // The result is identical for any threadCount. Compared to the exact product the
+    // componentwise error stays below ((n/n0)^log2(12) * (n0^2 + 5*n0) - 5*n) * u * max|A| * max|B.x|,
+    // with n0 the leaf size and u = 2^-53, against n * u * |A| * |B.x| for operator*.
+    // Memory: besides the result, packed copies of A, B.x and C take 56 bytes per cell of
+    // the padded size n' (n rounded up to n0 * 2^levels), and each thread's workspace
+    // about 19 bytes per cell. Threads are capped so the workspace stays below the packed
+    // copies (at most 3 run at once), so the peak extra memory is under 112 * n'^2 bytes:
+    // about 7.5 GB at n = 8192.
+    DynamicMatrix multiplyStrassen(const DynamicMatrix& other, size_t crossover = defaultStrassenCrossover,
+                                   size_t threadCount = 0) const;
+    // Times multiplyStrassen on a size x size matrix for a range of crossovers, returns the fastest
+    static size_t tuneStrassenCrossover(size_t size, size_t threadCount = 0);
+
+    // Marks the tiles other wrote since its last checkpoint, plus its clean tiles
+    // that hold nonzero values
+    DynamicMatrix& operator+=(const DynamicMatrix& other);
+
+    DynamicMatrix transpose() const;
+    void transposeInPlace();
+
     void deleteItem(size_t rowIndex, size_t colIndex);
     void addItem(size_t rowIndex, size_t colIndex, const Vector3D& vec);
     void addVectorAt(size_t rowIndex, size_t colIndex, const Vector3D& vec);
+    // Safe to call from many threads at once as long as the matrix isn't resized meanwhile
+    void atomicAddVectorAt(size_t rowIndex, size_t colIndex, const Vector3D& vec);
 
     bool operator==(const DynamicMatrix& other) const;
     bool operator!=(const DynamicMatrix& other) const;
@@ -59,8 +142,44 @@ public:
     void saveToFile(const std::string& filename) const;
     static DynamicMatrix loadFromFile(const std::string& filename);
 
+    // Delta checkpoints: saveBase writes a new base file and empties the delta file,
+    // saveDelta then appends every tile written since the last checkpoint and marks the
+    // matrix clean. The mutators track their own writes; writes made through the
+    // reference returned by at() are not tracked, mark them with markRegionDirty.
+    // Records are framed, checksummed and tagged with their base's checksum, so
+    // loadWithDeltas rejects records taken against another base (e.g. after a plain
+    // saveToFile) and ignores a torn last record. A failed save cuts its partial record
+    // off and leaves the matrix dirty. Matrices from loadFromFile or loadWithDeltas can
+    // append deltas against the file they came from.
+    void saveBase(const std::string& baseFile, const std::string& deltaFile);
+    void saveDelta(const std::string& filename);
+    void markClean();
+    void markRegionDirty(size_t rowBegin, size_t rowEnd, size_t colBegin, size_t colEnd);
+    void markAllDirty();
+    size_t dirtyTileCount() const;
+    static DynamicMatrix loadWithDeltas(const std::string& baseFile, const std::string& deltaFile);
+    // Folds the deltas into the base file and empties the delta file, like saveBase.
+    // Matrices still holding the old base must be reloaded before saving more deltas.
+    static void compactDeltas(const std::string& baseFile, const std::string& deltaFile);
+
+    // Sharded files: a manifest plus shardCount row-band files named <manifest>.g<n>.shard<i>,
+    // written and read concurrently on up to threadCount threads (0 = hardware concurrency).
+    // Every save writes a new generation n and syncs it before swapping the manifest, so a
+    // crash leaves the previous save loadable; older generations are removed afterwards.
+    // Once the manifest is swapped in the save has succeeded and no longer throws; if the
+    // swap can't be made durable the previous generation is kept for the next save to drop.
+    void saveSharded(const std::string& manifestFile, size_t shardCount, size_t threadCount = 0) const;
+    static DynamicMatrix loadSharded(const std::string& manifestFile, size_t threadCount = 0);
+    // Loads rows [rowBegin, rowEnd) only, touching just the shards that hold them
+    static DynamicMatrix loadShardedRows(const std::string& manifestFile, size_t rowBegin, size_t rowEnd,
+                                         size_t threadCount = 0);
+
     size_t getRows() const { return rows; }
     size_t getCols() const { return cols; }
 
+    MatrixLayout getLayout() const { return layout; }
+    // Converts the storage order, the logical contents stay the same
+    void setLayout(MatrixLayout newLayout);
+
     void print() const;
 };
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "dynamic_matrix.h"
+#include "vector3d_structure.h"
+#include <cstddef>
+#include <vector>
+
+enum class AccumulationMode {
+    Atomic,  // CAS adds straight into the target, no extra memory
+    Sharded  // per-thread private matrices, folded into the target by merge()
+};
+
+// Lets many threads scatter-add into one DynamicMatrix without an external mutex.
+// Each thread passes its own index in [0, threadCount) to add().
+// `make bench` compares both modes across thread counts and contention levels.
+class MatrixAccumulator {
+private:
+    DynamicMatrix& target;
+    AccumulationMode mode;
+    std::vector<DynamicMatrix> shards;
+
+public:
+    MatrixAccumulator(DynamicMatrix& target, size_t threadCount,
+                      AccumulationMode mode = AccumulationMode::Atomic);
+
+    void add(size_t threadIndex, size_t rowIndex, size_t colIndex, const Vector3D& vec);
+
+    // Must be called after all adding threads have joined; no-op in Atomic mode
+    void merge();
+
+    AccumulationMode getMode() const { return mode; }
+    size_t getThreadCount() const { return shards.size(); }
+};
@@ -0,0 +1,162 @@
+#pragma once
+
+#include "dynamic_matrix.h"
+#include "vector3d_structure.h"
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Lazy single-pass coroutine generator. Yielded values are referenced, not copied,
+// so a stage can modify the row it gets and yield it again.
+template <typename T>
+class Generator {
+public:
+    struct promise_type {
+        T* current = nullptr;
+        std::exception_ptr exception;
+
+        Generator get_return_object() {
+            return Generator(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        std::suspend_always yield_value(T& value) noexcept {
+            current = std::addressof(value);
+            return {};
+        }
+        std::suspend_always yield_value(T&& value) noexcept {
+            current = std::addressof(value);
+            return {};
+        }
+        void return_void() noexcept {}
+        void unhandled_exception() { exception = std::current_exception(); }
+    };
+
+    class Iterator {
+    private:
+        std::coroutine_handle<promise_type> handle;
+
+    public:
+        explicit Iterator(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+
+        T& operator*() const { return *handle.promise().current; }
+        Iterator& operator++() {
+            resume(handle);
+            return *this;
+        }
+        bool operator==(std::default_sentinel_t) const { return !handle || handle.done(); }
+    };
+
+    explicit Generator(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+    ~Generator() {
+        if (handle)
+            handle.destroy();
+    }
+
+    Generator(const Generator&) = delete;
+    Generator& operator=(const Generator&) = delete;
+
+    Generator(Generator&& other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+    Generator& operator=(Generator&& other) noexcept {
+        if (this != &other) {
+            if (handle)
+                handle.destroy();
+            handle = std::exchange(other.handle, nullptr);
+        }
+        return *this;
+    }
+
+    Iterator begin() {
+        resume(handle);
+        return Iterator(handle);
+    }
+    std::default_sentinel_t end() { return {}; }
+
+private:
+    std::coroutine_handle<promise_type> handle;
+
+    static void resume(std::coroutine_handle<promise_type> h) {
+        if (!h || h.done())
+            return;
+        h.resume();
+        if (h.promise().exception)
+            std::rethrow_exception(std::exchange(h.promise().exception, nullptr));
+    }
+};
+
+// Fixed-capacity blocking queue connecting two pipeline threads
+template <typename T>
+class BoundedQueue {
+private:
+    std::deque<T> items;
+    size_t capacity;
+    bool closed = false;
+    std::mutex mutex;
+    std::condition_variable notFull;
+    std::condition_variable notEmpty;
+
+public:
+    explicit BoundedQueue(size_t capacity) : capacity(capacity == 0 ? 1 : capacity) {}
+
+    // Returns false if the queue was closed, the item is dropped then
+    bool push(T item) {
+        std::unique_lock<std::mutex> lock(mutex);
+        notFull.wait(lock, [this]() { return closed || items.size() < capacity; });
+        if (closed)
+            return false;
+        items.push_back(std::move(item));
+        notEmpty.notify_one();
+        return true;
+    }
+
+    // Returns false once the queue is closed and drained
+    bool pop(T& item) {
+        std::unique_lock<std::mutex> lock(mutex);
+        notEmpty.wait(lock, [this]() { return closed || !items.empty(); });
+        if (items.empty())
+            return false;
+        item = std::move(items.front());
+        items.pop_front();
+        notFull.notify_one();
+        return true;
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        notFull.notify_all();
+        notEmpty.notify_all();
+    }
+};
+
+// Streaming row pipeline: sources yield one row at a time, stages transform rows as
+// they pass, sinks drain the stream. Only a handful of rows are alive at once.
+using Row = std::vector<Vector3D>;
+
+// Sources
+Generator<Row> readBinaryRows(const std::string& filename);
+// Whitespace-separated "x y z" triples, cols triples per row (the operator>> format)
+Generator<Row> readTextRows(const std::string& filename, size_t cols);
+Generator<Row> matrixRows(const DynamicMatrix& matrix);
+
+// Stages
+Generator<Row> mapRows(Generator<Row> rows, std::function<void(Row&)> transform);
+Generator<Row> mapCells(Generator<Row> rows, std::function<Vector3D(const Vector3D&)> transform);
+Generator<Row> filterRows(Generator<Row> rows, std::function<bool(const Row&)> predicate);
+Generator<Row> scaleRows(Generator<Row> rows, double scalar);
+// Drains the upstream stages on a worker thread, handing rows over through a bounded queue
+Generator<Row> runOnThread(Generator<Row> rows, size_t queueCapacity = 64);
+
+// Sinks, both return the number of rows written
+size_t writeBinaryRows(Generator<Row> rows, const std::string& filename);
+size_t writeTextRows(Generator<Row> rows, const std::string& filename);
+// Buffers the whole stream before building the matrix, peak memory is about twice its size
+DynamicMatrix collectRows(Generator<Row> rows);
@@ -1,35 +1,130 @@
 #include "dynamic_matrix.h"
 #include "vector3d_structure.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
 #include <cstddef>
+#include <cstdint>
+#include <cstdio>
 #include <stdexcept>
 #include <cstring>
+#include <exception>
+#include <filesystem>
+#include <functional>
+#include <fcntl.h>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+// Tile edge for the blocked kernels, 16x16 Vector3D tiles of both operands fit in L1
+static const size_t kBlockSize = 16;
+
+// Edge of a dirty-tracking tile, 64x64 cells share one bit
+static const size_t kCheckpointTile = 64;
+
+// Cache-oblivious out-of-place transpose of src[rowBegin..rowEnd)[colBegin..colEnd) into dst
+static void transposeBlocked(Vector3D* const* src, Vector3D** dst,
+                             size_t rowBegin, size_t rowEnd, size_t colBegin, size_t colEnd) {
+    const size_t rowSpan = rowEnd - rowBegin;
+    const size_t colSpan = colEnd - colBegin;
+
+    if (rowSpan <= kBlockSize && colSpan <= kBlockSize) {
+        for (size_t i = rowBegin; i < rowEnd; ++i)
+            for (size_t j = colBegin; j < colEnd; ++j)
+                dst[j][i] = src[i][j];
+        return;
+    }
+
+    if (rowSpan >= colSpan) {
+        const size_t mid = rowBegin + rowSpan / 2;
+        transposeBlocked(src, dst, rowBegin, mid, colBegin, colEnd);
+        transposeBlocked(src, dst, mid, rowEnd, colBegin, colEnd);
+    } else {
+        const size_t mid = colBegin + colSpan / 2;
+        transposeBlocked(src, dst, rowBegin, rowEnd, colBegin, mid);
+        transposeBlocked(src, dst, rowBegin, rowEnd, mid, colEnd);
+    }
+}
+
+// Swaps the block m[rowBegin..rowEnd)[colBegin..colEnd) with its mirror across the diagonal
+static void swapMirrorBlocks(Vector3D** m, size_t rowBegin, size_t rowEnd, size_t colBegin, size_t colEnd) {
+    const size_t rowSpan = rowEnd - rowBegin;
+    const size_t colSpan = colEnd - colBegin;
+
+    if (rowSpan <= kBlockSize && colSpan <= kBlockSize) {
+        for (size_t i = rowBegin; i < rowEnd; ++i)
+            for (size_t j = colBegin; j < colEnd; ++j)
+                std::swap(m[i][j], m[j][i]);
+        return;
+    }
+
+    if (rowSpan >= colSpan) {
+        const size_t mid = rowBegin + rowSpan / 2;
+        swapMirrorBlocks(m, rowBegin, mid, colBegin, colEnd);
+        swapMirrorBlocks(m, mid, rowEnd, colBegin, colEnd);
+    } else {
+        const size_t mid = colBegin + colSpan / 2;
+        swapMirrorBlocks(m, rowBegin, rowEnd, colBegin, mid);
+        swapMirrorBlocks(m, rowBegin, rowEnd, mid, colEnd);
+    }
+}
+
+// Cache-oblivious in-place transpose of the square diagonal block m[begin..end)[begin..end)
+static void transposeDiagonal(Vector3D** m, size_t begin, size_t end) {
+    if (end - begin <= kBlockSize) {
+        for (size_t i = begin; i < end; ++i)
+            for (size_t j = i + 1; j < end; ++j)
+                std::swap(m[i][j], m[j][i]);
+        return;
+    }
+
+    const size_t mid = begin + (end - begin) / 2;
+    transposeDiagonal(m, begin, mid);
+    transposeDiagonal(m, mid, end);
+    swapMirrorBlocks(m, begin, mid, mid, end);
+}
 
 void DynamicMatrix::allocateMemory() {
-    matrix = new Vector3D*[rows];
-    for (size_t i = 0; i < rows; ++i)
-        matrix[i] = new Vector3D[cols];
+    const size_t outer = outerSize();
+    const size_t inner = innerSize();
+    matrix = new Vector3D*[outer];
+    for (size_t i = 0; i < outer; ++i)
+        matrix[i] = new Vector3D[inner];
 }
 
 void DynamicMatrix::deallocateMemory() {
-    for (size_t i = 0; i < rows; ++i)
+    const size_t outer = outerSize();
+    for (size_t i = 0; i < outer; ++i)
         delete[] matrix[i];
 
     delete[] matrix;
 }
 
-DynamicMatrix::DynamicMatrix(size_t rows, size_t cols) : rows(rows), cols(cols) {
+DynamicMatrix::DynamicMatrix(size_t rows, size_t cols, MatrixLayout layout)
+    : rows(rows), cols(cols), layout(layout) {
     allocateMemory();
+    markAllDirty();
 }
 
 DynamicMatrix::~DynamicMatrix() {
     deallocateMemory();
 }
 
-DynamicMatrix::DynamicMatrix(const DynamicMatrix& other) : rows(other.rows), cols(other.cols) {
+// A copy has never been checkpointed, so it starts fully dirty like a new matrix
+DynamicMatrix::DynamicMatrix(const DynamicMatrix& other)
+    : rows(other.rows), cols(other.cols), layout(other.layout), checkpointBase(other.checkpointBase) {
     allocateMemory();
-    for (size_t i = 0; i < rows; ++i)
-        for (size_t j = 0; j < cols; ++j)
+    const size_t outer = outerSize();
+    const size_t inner = innerSize();
+    for (size_t i = 0; i < outer; ++i)
+        for (size_t j = 0; j < inner; ++j)
             matrix[i][j] = other.matrix[i][j];
+    markAllDirty();
 }
 
 DynamicMatrix& DynamicMatrix::operator=(const DynamicMatrix& other) {
@@ -37,16 +132,22 @@ DynamicMatrix& DynamicMatrix::operator=(const DynamicMatrix& other) {
         deallocateMemory();
         rows = other.rows;
         cols = other.cols;
+        layout = other.layout;
         allocateMemory();
-        for (size_t i = 0; i < rows; ++i)
-            for (size_t j = 0; j < cols; ++j)
+        const size_t outer = outerSize();
+        const size_t inner = innerSize();
+        for (size_t i = 0; i < outer; ++i)
+            for (size_t j = 0; j < inner; ++j)
                 matrix[i][j] = other.matrix[i][j];
+        // other's bits describe other's checkpoints, every cell of this one changed
+        markAllDirty();
     }
     return *this;
 }
 
 DynamicMatrix::DynamicMatrix(DynamicMatrix&& other) noexcept
-    : matrix(other.matrix), rows(other.rows), cols(other.cols) {
+    : matrix(other.matrix), rows(other.rows), cols(other.cols), layout(other.layout),
+      dirtyTiles(std::move(other.dirtyTiles)), checkpointBase(other.checkpointBase) {
     other.matrix = nullptr;
     other.rows = 0;
     other.cols = 0;
@@ -58,9 +159,14 @@ DynamicMatrix& DynamicMatrix::operator=(DynamicMatrix&& other) noexcept {
         matrix = other.matrix;
         rows = other.rows;
         cols = other.cols;
+        layout = other.layout;
         other.matrix = nullptr;
         other.rows = 0;
         other.cols = 0;
+        // other's bitmap is already sized for this shape, refilling it can't allocate
+        dirtyTiles.swap(other.dirtyTiles);
+        other.dirtyTiles.clear();
+        setAllDirtyBits();
     }
     return *this;
 }
@@ -68,88 +174,174 @@ DynamicMatrix& DynamicMatrix::operator=(DynamicMatrix&& other) noexcept {
 Vector3D& DynamicMatrix::at(size_t row, size_t col) {
     if (row >= rows || col >= cols)
         throw std::out_of_range("Matrix index out of range");
-    return matrix[row][col];
+    return cell(row, col);
 }
 
 const Vector3D& DynamicMatrix::at(size_t row, size_t col) const {
     if (row >= rows || col >= cols)
         throw std::out_of_range("Matrix index out of range");
-    return matrix[row][col];
+    return cell(row, col);
 }
 
-void DynamicMatrix::deleteRow(size_t row) {
-    if (row >= rows)
-        throw std::out_of_range("Row index out of range");
+size_t DynamicMatrix::tileRowCount() const {
+    return (rows + kCheckpointTile - 1) / kCheckpointTile;
+}
+
+size_t DynamicMatrix::tileColCount() const {
+    return (cols + kCheckpointTile - 1) / kCheckpointTile;
+}
+
+void DynamicMatrix::markDirty(size_t row, size_t col) {
+    const size_t tile = (row / kCheckpointTile) * tileColCount() + col / kCheckpointTile;
+    dirtyTiles[tile / 64] |= uint64_t(1) << (tile % 64);
+}
+
+void DynamicMatrix::markRegionDirty(size_t rowBegin, size_t rowEnd, size_t colBegin, size_t colEnd) {
+    if (rowBegin >= rowEnd || colBegin >= colEnd)
+        return;
+    for (size_t i = rowBegin / kCheckpointTile; i <= (rowEnd - 1) / kCheckpointTile; ++i)
+        for (size_t j = colBegin / kCheckpointTile; j <= (colEnd - 1) / kCheckpointTile; ++j)
+            markDirty(i * kCheckpointTile, j * kCheckpointTile);
+}
+
+// Also resizes the bitmap, so it's called after every shape change
+void DynamicMatrix::markAllDirty() {
+    dirtyTiles.resize((tileRowCount() * tileColCount() + 63) / 64);
+    setAllDirtyBits();
+}
+
+// Sets every tile bit of a bitmap that already has the right size
+void DynamicMatrix::setAllDirtyBits() noexcept {
+    const size_t tileCount = tileRowCount() * tileColCount();
+    std::fill(dirtyTiles.begin(), dirtyTiles.end(), ~uint64_t(0));
+    if (tileCount % 64 != 0)
+        dirtyTiles.back() = (uint64_t(1) << (tileCount % 64)) - 1;
+}
+
+void DynamicMatrix::markClean() {
+    std::fill(dirtyTiles.begin(), dirtyTiles.end(), 0);
+}
+
+size_t DynamicMatrix::dirtyTileCount() const {
+    size_t count = 0;
+    for (uint64_t word : dirtyTiles)
+        count += __builtin_popcountll(word);
+    return count;
+}
 
-    Vector3D** newMatrix = new Vector3D*[rows - 1];
+void DynamicMatrix::removeOuter(size_t index) {
+    const size_t outer = outerSize();
+    Vector3D** newMatrix = new Vector3D*[outer - 1];
 
-    for (size_t i = 0, newI = 0; i < rows; ++i) {
-        if (i != row)
+    for (size_t i = 0, newI = 0; i < outer; ++i) {
+        if (i != index)
             newMatrix[newI++] = matrix[i];
         else
             delete[] matrix[i];
     }
     delete[] matrix;
     matrix = newMatrix;
-    --rows;
 }
 
-void DynamicMatrix::deleteColumn(size_t col) {
-    if (col >= cols)
-        throw std::out_of_range("Column index out of range");
+void DynamicMatrix::removeInner(size_t index) {
+    const size_t outer = outerSize();
+    const size_t inner = innerSize();
 
-    for (size_t i = 0; i < rows; ++i) {
-        Vector3D* newRow = new Vector3D[cols - 1];
-        for (size_t j = 0, newJ = 0; j < cols; ++j)
-            if (j != col)
-                newRow[newJ++] = matrix[i][j];
+    for (size_t i = 0; i < outer; ++i) {
+        Vector3D* newLine = new Vector3D[inner - 1];
+        for (size_t j = 0, newJ = 0; j < inner; ++j)
+            if (j != index)
+                newLine[newJ++] = matrix[i][j];
 
         delete[] matrix[i];
-        matrix[i] = newRow;
+        matrix[i] = newLine;
     }
-    --cols;
 }
 
-void DynamicMatrix::insertRow(size_t rowIndex, const Vector3D* newRow) {
-    if (rowIndex > rows)
-        throw std::out_of_range("Row index out of range");
-
-    Vector3D** newMatrix = new Vector3D*[rows + 1];
+void DynamicMatrix::insertOuter(size_t index, const Vector3D* values) {
+    const size_t outer = outerSize();
+    const size_t inner = innerSize();
+    Vector3D** newMatrix = new Vector3D*[outer + 1];
 
-    for (size_t i = 0; i < rowIndex; ++i)
+    for (size_t i = 0; i < index; ++i)
         newMatrix[i] = matrix[i];
 
-    newMatrix[rowIndex] = new Vector3D[cols];
-    for (size_t j = 0; j < cols; ++j)
-        newMatrix[rowIndex][j] = newRow[j];
+    newMatrix[index] = new Vector3D[inner];
+    for (size_t j = 0; j < inner; ++j)
+        newMatrix[index][j] = values[j];
 
-    for (size_t i = rowIndex; i < rows; ++i)
+    for (size_t i = index; i < outer; ++i)
         newMatrix[i + 1] = matrix[i];
 
     delete[] matrix;
     matrix = newMatrix;
-    ++rows;
 }
 
-void DynamicMatrix::insertColumn(size_t colIndex, const Vector3D* newColumn) {
-    if (colIndex > cols)
-        throw std::out_of_range("Column index out of range");
-
-    for (size_t i = 0; i < rows; ++i) {
+void DynamicMatrix::insertInner(size_t index, const Vector3D* values) {
+    const size_t outer = outerSize();
+    const size_t inner = innerSize();
 
-        Vector3D* newRow = new Vector3D[cols + 1];
+    for (size_t i = 0; i < outer; ++i) {
+        Vector3D* newLine = new Vector3D[inner + 1];
 
-        for (size_t j = 0; j < colIndex; ++j)
-            newRow[j] = matrix[i][j];
+        for (size_t j = 0; j < index; ++j)
+            newLine[j] = matrix[i][j];
 
-        newRow[colIndex] = newColumn[i];
-        for (size_t j = colIndex; j < cols; ++j)
-            newRow[j + 1] = matrix[i][j];
+        newLine[index] = values[i];
+        for (size_t j = index; j < inner; ++j)
+            newLine[j + 1] = matrix[i][j];
 
         delete[] matrix[i];
-        matrix[i] = newRow;
+        matrix[i] = newLine;
     }
+}
+
+void DynamicMatrix::deleteRow(size_t row) {
+    if (row >= rows)
+        throw std::out_of_range("Row index out of range");
+
+    if (layout == MatrixLayout::RowMajor)
+        removeOuter(row);
+    else
+        removeInner(row);
+    --rows;
+    markAllDirty();
+}
+
+void DynamicMatrix::deleteColumn(size_t col) {
+    if (col >= cols)
+        throw std::out_of_range("Column index out of range");
+
+    if (layout == MatrixLayout::ColumnMajor)
+        removeOuter(col);
+    else
+        removeInner(col);
+    --cols;
+    markAllDirty();
+}
+
+void DynamicMatrix::insertRow(size_t rowIndex, const Vector3D* newRow) {
+    if (rowIndex > rows)
+        throw std::out_of_range("Row index out of range");
+
+    if (layout == MatrixLayout::RowMajor)
+        insertOuter(rowIndex, newRow);
+    else
+        insertInner(rowIndex, newRow);
+    ++rows;
+    markAllDirty();
+}
+
+void DynamicMatrix::insertColumn(size_t colIndex, const Vector3D* newColumn) {
+    if (colIndex > cols)
+        throw std::out_of_range("Column index out of range");
+
+    if (layout == MatrixLayout::ColumnMajor)
+        insertOuter(colIndex, newColumn);
+    else
+        insertInner(colIndex, newColumn);
     ++cols;
+    markAllDirty();
 }
 
 void DynamicMatrix::insertSubmatrix(const DynamicMatrix& submatrix, size_t startRow, size_t startCol) {
@@ -158,17 +350,41 @@ void DynamicMatrix::insertSubmatrix(const DynamicMatrix& submatrix, size_t start
 
     for (size_t row = 0; row < submatrix.rows; ++row)
         for (size_t col = 0; col < submatrix.cols; ++col)
-          matrix[startRow + row][startCol + col] = submatrix.matrix[row][col];
+          cell(startRow + row, startCol + col) = submatrix.cell(row, col);
+
+    markRegionDirty(startRow, startRow + submatrix.rows, startCol, startCol + submatrix.cols);
+}
+
+// result(i, j) = op(lhs(i, j), rhs(i, j)), result must share lhs's layout
+template <typename Op>
+void DynamicMatrix::elementwise(DynamicMatrix& result, const DynamicMatrix& lhs, const DynamicMatrix& rhs, Op op) {
+    const size_t outer = lhs.outerSize();
+    const size_t inner = lhs.innerSize();
+
+    if (lhs.layout == rhs.layout) {
+        for (size_t i = 0; i < outer; ++i)
+            for (size_t j = 0; j < inner; ++j)
+                result.matrix[i][j] = op(lhs.matrix[i][j], rhs.matrix[i][j]);
+        return;
+    }
+
+    // Mixed layouts: rhs storage is lhs storage transposed, walk it in tiles
+    for (size_t ib = 0; ib < outer; ib += kBlockSize)
+        for (size_t jb = 0; jb < inner; jb += kBlockSize) {
+            const size_t iEnd = std::min(ib + kBlockSize, outer);
+            const size_t jEnd = std::min(jb + kBlockSize, inner);
+            for (size_t i = ib; i < iEnd; ++i)
+                for (size_t j = jb; j < jEnd; ++j)
+                    result.matrix[i][j] = op(lhs.matrix[i][j], rhs.matrix[j][i]);
+        }
 }
 
 DynamicMatrix DynamicMatrix::operator+(const DynamicMatrix& other) const {
     if (rows != other.rows || cols != other.cols)
         throw std::invalid_argument("Matrix dimensions don't match for addition");
 
-    DynamicMatrix result(rows, cols);
-    for (size_t i = 0; i < rows; ++i)
-        for (size_t j = 0; j < cols; ++j)
-            result.matrix[i][j] = matrix[i][j] + other.matrix[i][j];
+    DynamicMatrix result(rows, cols, layout);
+    elementwise(result, *this, other, [](const Vector3D& a, const Vector3D& b) { return a + b; });
 
     return result;
 }
@@ -177,10 +393,8 @@ DynamicMatrix DynamicMatrix::operator-(const DynamicMatrix& other) const {
     if (rows != other.rows || cols != other.cols)
         throw std::invalid_argument("Matrix dimensions don't match for subtraction");
 
-    DynamicMatrix result(rows, cols);
-    for (size_t i = 0; i < rows; ++i)
-        for (size_t j = 0; j < cols; ++j)
-            result.matrix[i][j] = matrix[i][j] - other.matrix[i][j];
+    DynamicMatrix result(rows, cols, layout);
+    elementwise(result, *this, other, [](const Vector3D& a, const Vector3D& b) { return a - b; });
 
     return result;
 }
@@ -189,31 +403,360 @@ DynamicMatrix DynamicMatrix::operator*(const DynamicMatrix& other) const {
     if (cols != other.rows)
         throw std::invalid_argument("Matrix dimensions don't match for multiplication");
 
-    DynamicMatrix result(rows, other.cols);
+    // The result takes this matrix's layout. Each operand pair gets the loop order
+    // that keeps the innermost loop on contiguous memory; every cell still
+    // accumulates its k terms in ascending order, so all paths agree bitwise.
+    DynamicMatrix result(rows, other.cols, layout);
+    const size_t n = rows;
+    const size_t m = other.cols;
+    const size_t depth = cols;
+
+    if (layout == MatrixLayout::RowMajor && other.layout == MatrixLayout::ColumnMajor) {
+        for (size_t i = 0; i < n; ++i)
+            for (size_t j = 0; j < m; ++j) {
+                Vector3D sum;
+                for (size_t k = 0; k < depth; ++k)
+                    sum = sum + matrix[i][k] * other.matrix[j][k].x;
+                result.matrix[i][j] = sum;
+            }
+    } else if (layout == MatrixLayout::RowMajor) {
+        for (size_t i = 0; i < n; ++i)
+            for (size_t k = 0; k < depth; ++k) {
+                const Vector3D a = matrix[i][k];
+                for (size_t j = 0; j < m; ++j)
+                    result.matrix[i][j] = result.matrix[i][j] + a * other.matrix[k][j].x;
+            }
+    } else if (other.layout == MatrixLayout::ColumnMajor) {
+        for (size_t j = 0; j < m; ++j)
+            for (size_t k = 0; k < depth; ++k) {
+                const double b = other.matrix[j][k].x;
+                for (size_t i = 0; i < n; ++i)
+                    result.matrix[j][i] = result.matrix[j][i] + matrix[k][i] * b;
+            }
+    } else {
+        for (size_t k = 0; k < depth; ++k)
+            for (size_t j = 0; j < m; ++j) {
+                const double b = other.matrix[k][j].x;
+                for (size_t i = 0; i < n; ++i)
+                    result.matrix[j][i] = result.matrix[j][i] + matrix[k][i] * b;
+            }
+    }
+
+    return result;
+}
+
+// Strided view of a square block inside a packed row-major buffer
+template <typename T>
+struct Block {
+    T* data;
+    size_t stride;
+
+    T& operator()(size_t i, size_t j) const { return data[i * stride + j]; }
+    Block quadrant(size_t qi, size_t qj, size_t half) const {
+        return Block{data + qi * half * stride + qj * half, stride};
+    }
+};
+
+template <typename T>
+static void copyBlock(Block<T> out, Block<T> a, size_t size) {
+    for (size_t i = 0; i < size; ++i)
+        for (size_t j = 0; j < size; ++j)
+            out(i, j) = a(i, j);
+}
+
+template <typename T>
+static void addBlocks(Block<T> out, Block<T> a, Block<T> b, size_t size) {
+    for (size_t i = 0; i < size; ++i)
+        for (size_t j = 0; j < size; ++j)
+            out(i, j) = a(i, j) + b(i, j);
+}
+
+template <typename T>
+static void subtractBlocks(Block<T> out, Block<T> a, Block<T> b, size_t size) {
+    for (size_t i = 0; i < size; ++i)
+        for (size_t j = 0; j < size; ++j)
+            out(i, j) = a(i, j) - b(i, j);
+}
+
+// c = a * b with the classic kernel in i-k-j order
+static void multiplyBase(Block<Vector3D> c, Block<Vector3D> a, Block<double> b, size_t size) {
+    for (size_t i = 0; i < size; ++i) {
+        for (size_t j = 0; j < size; ++j)
+            c(i, j) = Vector3D();
+        for (size_t k = 0; k < size; ++k) {
+            const Vector3D left = a(i, k);
+            for (size_t j = 0; j < size; ++j)
+                c(i, j) = c(i, j) + left * b(k, j);
+        }
+    }
+}
+
+// Workspace needed by strassenRecursive for one block of the given size
+static void strassenWorkspace(size_t size, size_t crossover, size_t& vectors, size_t& scalars) {
+    vectors = 0;
+    scalars = 0;
+    for (; size > crossover; size /= 2) {
+        const size_t half = size / 2;
+        vectors += 2 * half * half;
+        scalars += half * half;
+    }
+}
+
+struct StrassenQuadrants {
+    Block<Vector3D> a11, a12, a21, a22;
+    Block<double> b11, b12, b21, b22;
+    Block<Vector3D> c11, c12, c21, c22;
+
+    StrassenQuadrants(Block<Vector3D> c, Block<Vector3D> a, Block<double> b, size_t half)
+        : a11(a.quadrant(0, 0, half)), a12(a.quadrant(0, 1, half)),
+          a21(a.quadrant(1, 0, half)), a22(a.quadrant(1, 1, half)),
+          b11(b.quadrant(0, 0, half)), b12(b.quadrant(0, 1, half)),
+          b21(b.quadrant(1, 0, half)), b22(b.quadrant(1, 1, half)),
+          c11(c.quadrant(0, 0, half)), c12(c.quadrant(0, 1, half)),
+          c21(c.quadrant(1, 0, half)), c22(c.quadrant(1, 1, half)) {}
+};
+
+static void strassenRecursive(Block<Vector3D> c, Block<Vector3D> a, Block<double> b, size_t size,
+                              size_t crossover, Vector3D* vectorWork, double* scalarWork);
+
+// m = M_index, using ta/tb for the operand sums
+static void strassenProduct(int index, const StrassenQuadrants& q, Block<Vector3D> m,
+                            Block<Vector3D> ta, Block<double> tb, size_t half,
+                            size_t crossover, Vector3D* vectorWork, double* scalarWork) {
+    Block<Vector3D> left = ta;
+    Block<double> right = tb;
+    switch (index) {
+    case 0: addBlocks(ta, q.a11, q.a22, half); addBlocks(tb, q.b11, q.b22, half); break;
+    case 1: addBlocks(ta, q.a21, q.a22, half); right = q.b11; break;
+    case 2: left = q.a11; subtractBlocks(tb, q.b12, q.b22, half); break;
+    case 3: left = q.a22; subtractBlocks(tb, q.b21, q.b11, half); break;
+    case 4: addBlocks(ta, q.a11, q.a12, half); right = q.b22; break;
+    case 5: subtractBlocks(ta, q.a21, q.a11, half); addBlocks(tb, q.b11, q.b12, half); break;
+    case 6: subtractBlocks(ta, q.a12, q.a22, half); addBlocks(tb, q.b21, q.b22, half); break;
+    }
+    strassenRecursive(m, left, right, half, crossover, vectorWork, scalarWork);
+}
+
+// Folds M_index into the result quadrants. Products must be folded in index order,
+// the first product touching a quadrant overwrites it.
+static void strassenCombine(int index, const StrassenQuadrants& q, Block<Vector3D> m, size_t half) {
+    switch (index) {
+    case 0: copyBlock(q.c11, m, half); copyBlock(q.c22, m, half); break;
+    case 1: copyBlock(q.c21, m, half); subtractBlocks(q.c22, q.c22, m, half); break;
+    case 2: copyBlock(q.c12, m, half); addBlocks(q.c22, q.c22, m, half); break;
+    case 3: addBlocks(q.c11, q.c11, m, half); addBlocks(q.c21, q.c21, m, half); break;
+    case 4: subtractBlocks(q.c11, q.c11, m, half); addBlocks(q.c12, q.c12, m, half); break;
+    case 5: addBlocks(q.c22, q.c22, m, half); break;
+    case 6: addBlocks(q.c11, q.c11, m, half); break;
+    }
+}
+
+static void strassenRecursive(Block<Vector3D> c, Block<Vector3D> a, Block<double> b, size_t size,
+                              size_t crossover, Vector3D* vectorWork, double* scalarWork) {
+    if (size <= crossover) {
+        multiplyBase(c, a, b, size);
+        return;
+    }
+
+    const size_t half = size / 2;
+    const StrassenQuadrants q(c, a, b, half);
+    Block<Vector3D> m{vectorWork, half};
+    Block<Vector3D> ta{vectorWork + half * half, half};
+    Block<double> tb{scalarWork, half};
+
+    for (int index = 0; index < 7; ++index) {
+        strassenProduct(index, q, m, ta, tb, half, crossover,
+                        vectorWork + 2 * half * half, scalarWork + half * half);
+        strassenCombine(index, q, m, half);
+    }
+}
+
+DynamicMatrix DynamicMatrix::multiplyStrassen(const DynamicMatrix& other, size_t crossover, size_t threadCount) const {
+    if (cols != other.rows)
+        throw std::invalid_argument("Matrix dimensions don't match for multiplication");
+
+    crossover = std::max<size_t>(crossover, 1);
+    if (rows != cols || other.rows != other.cols || rows <= crossover)
+        return *this * other;
+
+    // Pad to leaf * 2^levels with the smallest leaf not above the crossover
+    size_t leaf = rows;
+    size_t levels = 0;
+    for (; leaf > crossover; ++levels)
+        leaf = (leaf + 1) / 2;
+    const size_t size = leaf << levels;
+    const size_t half = size / 2;
+
+    std::vector<Vector3D> packedA(size * size);
+    std::vector<double> packedB(size * size, 0.0);
+    std::vector<Vector3D> packedC(size * size);
     for (size_t i = 0; i < rows; ++i)
-        for (size_t j = 0; j < other.cols; ++j) {
-            Vector3D sum;
-            for (size_t k = 0; k < cols; ++k)
-                sum = sum + matrix[i][k] * other.matrix[k][j].x;
-            result.matrix[i][j] = sum;
+        for (size_t j = 0; j < cols; ++j) {
+            packedA[i * size + j] = cell(i, j);
+            packedB[i * size + j] = other.cell(i, j).x;
         }
 
+    const Block<Vector3D> c{packedC.data(), size};
+    const StrassenQuadrants q(c, Block<Vector3D>{packedA.data(), size}, Block<double>{packedB.data(), size}, half);
+
+    size_t childVectors, childScalars;
+    strassenWorkspace(half, crossover, childVectors, childScalars);
+    const size_t slotVectors = 2 * half * half + childVectors;
+    const size_t slotScalars = half * half + childScalars;
+
+    // Each worker owns one slot (its product, the operand sums and the recursion
+    // workspace). Slots are capped so together they never outgrow the packed copies,
+    // which bounds the peak at about twice the packed size whatever threadCount is.
+    const size_t packedBytes = size * size * (2 * sizeof(Vector3D) + sizeof(double));
+    const size_t slotBytes = slotVectors * sizeof(Vector3D) + slotScalars * sizeof(double);
+    if (threadCount == 0)
+        threadCount = std::max<size_t>(1, std::thread::hardware_concurrency());
+    threadCount = std::min<size_t>({threadCount, 7, std::max<size_t>(1, packedBytes / slotBytes)});
+
+    std::vector<Vector3D> vectorWork(threadCount * slotVectors);
+    std::vector<double> scalarWork(threadCount * slotScalars);
+    std::atomic<int> nextProduct(0);
+
+    // Products are folded into C in index order as soon as the earlier ones are in,
+    // so the result is the same for any thread count without keeping all seven
+    std::mutex foldMutex;
+    std::condition_variable folded;
+    int nextFold = 0;
+
+    auto worker = [&](size_t slot) {
+        Vector3D* vectors = vectorWork.data() + slot * slotVectors;
+        double* scalars = scalarWork.data() + slot * slotScalars;
+        const Block<Vector3D> m{vectors, half};
+        for (int index = nextProduct++; index < 7; index = nextProduct++) {
+            strassenProduct(index, q, m, Block<Vector3D>{vectors + half * half, half}, Block<double>{scalars, half},
+                            half, crossover, vectors + 2 * half * half, scalars + half * half);
+
+            std::unique_lock<std::mutex> lock(foldMutex);
+            folded.wait(lock, [&]() { return nextFold == index; });
+            lock.unlock();
+            strassenCombine(index, q, m, half);
+            lock.lock();
+            ++nextFold;
+            folded.notify_all();
+        }
+    };
+
+    if (threadCount == 1) {
+        worker(0);
+    } else {
+        std::vector<std::thread> workers;
+        for (size_t slot = 0; slot < threadCount; ++slot)
+            workers.emplace_back(worker, slot);
+        for (std::thread& thread : workers)
+            thread.join();
+    }
+
+    DynamicMatrix result(rows, cols, layout);
+    for (size_t i = 0; i < rows; ++i)
+        for (size_t j = 0; j < cols; ++j)
+            result.cell(i, j) = packedC[i * size + j];
+
     return result;
 }
 
+size_t DynamicMatrix::tuneStrassenCrossover(size_t size, size_t threadCount) {
+    DynamicMatrix a(size, size);
+    DynamicMatrix b(size, size);
+    for (size_t i = 0; i < size; ++i)
+        for (size_t j = 0; j < size; ++j) {
+            a.cell(i, j) = Vector3D(double(i % 7) - 3, double(j % 5) - 2, double((i + j) % 3));
+            b.cell(i, j) = Vector3D(double((i * j) % 11) - 5, 0, 0);
+        }
+
+    size_t best = defaultStrassenCrossover;
+    double bestSeconds = -1;
+    for (size_t crossover = 16; crossover <= 512; crossover *= 2) {
+        const auto start = std::chrono::steady_clock::now();
+        a.multiplyStrassen(b, crossover, threadCount);
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (bestSeconds < 0 || seconds < bestSeconds) {
+            bestSeconds = seconds;
+            best = crossover;
+        }
+    }
+    return best;
+}
+
 DynamicMatrix DynamicMatrix::operator*(double scalar) const {
-    DynamicMatrix result(rows, cols);
-    for (size_t i = 0; i < rows; ++i)
-        for (size_t j = 0; j < cols; ++j)
+    DynamicMatrix result(rows, cols, layout);
+    const size_t outer = outerSize();
+    const size_t inner = innerSize();
+    for (size_t i = 0; i < outer; ++i)
+        for (size_t j = 0; j < inner; ++j)
             result.matrix[i][j] = matrix[i][j] * scalar;
 
     return result;
 }
 
+DynamicMatrix& DynamicMatrix::operator+=(const DynamicMatrix& other) {
+    if (rows != other.rows || cols != other.cols)
+        throw std::invalid_argument("Matrix dimensions don't match for addition");
+
+    elementwise(*this, *this, other, [](const Vector3D& a, const Vector3D& b) { return a + b; });
+
+    // A tile changes if other wrote to it since its last checkpoint or, for clean
+    // tiles (other may have been loaded from a file), if it holds anything nonzero
+    const size_t tileCount = tileRowCount() * tileColCount();
+    for (size_t tile = 0; tile < tileCount; ++tile) {
+        const uint64_t bit = uint64_t(1) << (tile % 64);
+        if (other.dirtyTiles[tile / 64] & bit) {
+            dirtyTiles[tile / 64] |= bit;
+            continue;
+        }
+
+        const size_t rowBegin = (tile / tileColCount()) * kCheckpointTile;
+        const size_t colBegin = (tile % tileColCount()) * kCheckpointTile;
+        const size_t rowEnd = std::min(rowBegin + kCheckpointTile, rows);
+        const size_t colEnd = std::min(colBegin + kCheckpointTile, cols);
+        bool changed = false;
+        for (size_t i = rowBegin; i < rowEnd && !changed; ++i)
+            for (size_t j = colBegin; j < colEnd && !changed; ++j) {
+                const Vector3D& vec = other.cell(i, j);
+                changed = vec.x != 0 || vec.y != 0 || vec.z != 0;
+            }
+        if (changed)
+            dirtyTiles[tile / 64] |= bit;
+    }
+
+    return *this;
+}
+
+DynamicMatrix DynamicMatrix::transpose() const {
+    DynamicMatrix result(cols, rows, layout);
+    transposeBlocked(matrix, result.matrix, 0, outerSize(), 0, innerSize());
+    return result;
+}
+
+void DynamicMatrix::transposeInPlace() {
+    if (rows != cols)
+        throw std::invalid_argument("In-place transpose requires a square matrix");
+
+    transposeDiagonal(matrix, 0, rows);
+    markAllDirty();
+}
+
+void DynamicMatrix::setLayout(MatrixLayout newLayout) {
+    if (newLayout == layout)
+        return;
+
+    // A row-major matrix read as column-major is its own transpose
+    DynamicMatrix converted(rows, cols, newLayout);
+    transposeBlocked(matrix, converted.matrix, 0, outerSize(), 0, innerSize());
+    // Same logical contents, so the checkpoint state carries over unchanged
+    std::vector<uint64_t> dirty = std::move(dirtyTiles);
+    *this = std::move(converted);
+    dirtyTiles = std::move(dirty);
+}
+
 void DynamicMatrix::print() const {
     for (size_t i = 0; i < rows; ++i) {
         for (size_t j = 0; j < cols; ++j)
-            std::cout << matrix[i][j] << " ";
+            std::cout << cell(i, j) << " ";
 
         std::cout << std::endl;
     }
@@ -223,28 +766,49 @@ void DynamicMatrix::deleteItem(size_t rowIndex, size_t colIndex) {
     if (rowIndex >= rows || colIndex >= cols) {
         throw std::out_of_range("Invalid index for deletion");
     }
-    matrix[rowIndex][colIndex] = Vector3D();
+    cell(rowIndex, colIndex) = Vector3D();
+    markDirty(rowIndex, colIndex);
 }
 
 void DynamicMatrix::addItem(size_t rowIndex, size_t colIndex, const Vector3D& vec) {
     if (rowIndex >= rows || colIndex >= cols) {
         throw std::out_of_range("Invalid index for addition");
     }
-    matrix[rowIndex][colIndex] = vec;  // Insert the vector at the given position
+    cell(rowIndex, colIndex) = vec;  // Insert the vector at the given position
+    markDirty(rowIndex, colIndex);
 }
 
 void DynamicMatrix::addVectorAt(size_t rowIndex, size_t colIndex, const Vector3D& vec) {
     if (rowIndex >= rows || colIndex >= cols) {
         throw std::out_of_range("Invalid index for vector addition");
     }
-    matrix[rowIndex][colIndex] = matrix[rowIndex][colIndex] + vec;  // Add vector
+    cell(rowIndex, colIndex) = cell(rowIndex, colIndex) + vec;  // Add vector
+    markDirty(rowIndex, colIndex);
+}
+
+void DynamicMatrix::atomicAddVectorAt(size_t rowIndex, size_t colIndex, const Vector3D& vec) {
+    if (rowIndex >= rows || colIndex >= cols) {
+        throw std::out_of_range("Invalid index for vector addition");
+    }
+    Vector3D& target = cell(rowIndex, colIndex);
+    // Each component is updated independently with a lock-free CAS loop
+    std::atomic_ref<double>(target.x).fetch_add(vec.x, std::memory_order_relaxed);
+    std::atomic_ref<double>(target.y).fetch_add(vec.y, std::memory_order_relaxed);
+    std::atomic_ref<double>(target.z).fetch_add(vec.z, std::memory_order_relaxed);
+
+    const size_t tile = (rowIndex / kCheckpointTile) * tileColCount() + colIndex / kCheckpointTile;
+    const uint64_t bit = uint64_t(1) << (tile % 64);
+    std::atomic_ref<uint64_t> word(dirtyTiles[tile / 64]);
+    // Plain load first so hot tiles don't keep bouncing the bitmap cache line
+    if (!(word.load(std::memory_order_relaxed) & bit))
+        word.fetch_or(bit, std::memory_order_relaxed);
 }
 
 bool DynamicMatrix::operator==(const DynamicMatrix& other) const {
     if (rows != other.rows || cols != other.cols) return false;
     for (size_t i = 0; i < rows; ++i) {
         for (size_t j = 0; j < cols; ++j) {
-            if (!(matrix[i][j] == other.matrix[i][j])) return false;
+            if (!(cell(i, j) == other.cell(i, j))) return false;
         }
     }
     return true;
@@ -270,21 +834,257 @@ bool DynamicMatrix::operator>=(const DynamicMatrix& other) const {
     return !(*this < other);
 }
 
-// Helper function to calculate total magnitude of vectors
-double DynamicMatrix::totalMagnitude() const {
+// One branch-free Neumaier step, the selects compile to blends so lanes vectorize
+static inline void neumaierAdd(double& sum, double& compensation, double value) {
+    const double t = sum + value;
+    const bool sumIsLarger = std::fabs(sum) >= std::fabs(value);
+    const double larger = sumIsLarger ? sum : value;
+    const double smaller = sumIsLarger ? value : sum;
+    compensation += (larger - t) + smaller;
+    sum = t;
+}
+
+// Same arithmetic as Vector3D::lenght, inlined so the reduction loop can vectorize
+static inline double cellLength(const Vector3D& vec) {
+    return std::sqrt(vec.x * vec.x + vec.y * vec.y + vec.z * vec.z);
+}
+
+// Neumaier-compensated running sum
+struct CompensatedSum {
     double sum = 0;
-    for (size_t i = 0; i < rows; ++i) {
-        for (size_t j = 0; j < cols; ++j) {
-            sum += matrix[i][j].lenght();  // Use the length method of Vector3D
+    double compensation = 0;
+
+    void add(double value) { neumaierAdd(sum, compensation, value); }
+
+    void add(const CompensatedSum& other) {
+        add(other.sum);
+        compensation += other.compensation;
+    }
+
+    double value() const { return sum + compensation; }
+};
+
+struct NormPartial {
+    CompensatedSum sum;
+    double min = 0;
+    double max = 0;
+};
+
+// Helper threads shared by all reductions, so callers such as operator< don't pay
+// for thread creation on every call. The pool starts empty and grows to the largest
+// thread count asked for, up to kMaxReductionThreads.
+static const size_t kMaxReductionThreads = 64;
+
+class ReductionPool {
+private:
+    std::vector<std::thread> workers;
+    std::mutex runMutex;  // one reduction at a time, others run inline
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    const std::function<void(size_t)>* job = nullptr;
+    size_t taskCount = 0;
+    std::atomic<size_t> nextTask{0};
+    size_t slots = 0;
+    size_t finished = 0;
+    size_t generation = 0;
+    bool stopping = false;
+
+    void drain(const std::function<void(size_t)>& task, size_t count) {
+        for (size_t index = nextTask++; index < count; index = nextTask++)
+            task(index);
+    }
+
+    void workerLoop(size_t seen) {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            wake.wait(lock, [&]() { return stopping || generation != seen; });
+            if (stopping)
+                return;
+            seen = generation;
+            if (slots == 0)
+                continue;
+            --slots;
+            const std::function<void(size_t)>& task = *job;
+            const size_t count = taskCount;
+            lock.unlock();
+            drain(task, count);
+            lock.lock();
+            ++finished;
+            done.notify_one();
         }
     }
-    return sum;
+
+    // Called with runMutex held, so no run is in flight while helpers are added
+    void grow(size_t helpers) {
+        std::lock_guard<std::mutex> lock(mutex);
+        while (workers.size() < helpers)
+            workers.emplace_back([this, seen = generation]() { workerLoop(seen); });
+    }
+
+public:
+    ReductionPool() = default;
+
+    ~ReductionPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& worker : workers)
+            worker.join();
+    }
+
+    static ReductionPool& instance() {
+        static ReductionPool pool;
+        return pool;
+    }
+
+    size_t size() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return workers.size();
+    }
+
+    // Runs task(0..count) on the caller plus up to threadLimit - 1 pool threads
+    void run(size_t count, size_t threadLimit, const std::function<void(size_t)>& task) {
+        std::unique_lock<std::mutex> runLock(runMutex, std::try_to_lock);
+        const size_t helpers = runLock ? std::min({threadLimit, kMaxReductionThreads, count}) - 1 : 0;
+        if (helpers > 0)
+            grow(helpers);
+        if (helpers == 0) {
+            for (size_t index = 0; index < count; ++index)
+                task(index);
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job = &task;
+            taskCount = count;
+            nextTask = 0;
+            slots = helpers;
+            finished = 0;
+            ++generation;
+        }
+        wake.notify_all();
+
+        drain(task, count);
+
+        std::unique_lock<std::mutex> lock(mutex);
+        // Helpers that never claimed a slot don't count, only wait for the ones that did
+        done.wait(lock, [&]() { return finished == helpers - slots; });
+        slots = 0;
+        job = nullptr;
+    }
+};
+
+// Reduction leaves are fixed 32x32 tiles, so the summation tree depends only on
+// the matrix shape and never on how the tiles are spread across threads
+static const size_t kReductionTile = 32;
+static const size_t kReductionLanes = 4;
+static const size_t kParallelReductionCells = 1 << 16;
+
+NormReduction DynamicMatrix::reduceNorms(size_t threadCount) const {
+    if (rows == 0 || cols == 0)
+        return NormReduction{0, 0, 0};
+
+    const size_t tileRows = (rows + kReductionTile - 1) / kReductionTile;
+    const size_t tileCols = (cols + kReductionTile - 1) / kReductionTile;
+    const size_t tileCount = tileRows * tileCols;
+    std::vector<NormPartial> partials(tileCount);
+
+    auto reduceTile = [this, tileCols, &partials](size_t tile) {
+        const size_t rowBegin = (tile / tileCols) * kReductionTile;
+        const size_t colBegin = (tile % tileCols) * kReductionTile;
+        const size_t rowEnd = std::min(rowBegin + kReductionTile, rows);
+        const size_t colEnd = std::min(colBegin + kReductionTile, cols);
+
+        // Column j of the tile always feeds lane (j - colBegin) % 4, whatever the layout
+        double sums[kReductionLanes] = {};
+        double compensations[kReductionLanes] = {};
+        double lows[kReductionLanes];
+        double highs[kReductionLanes];
+        std::fill(lows, lows + kReductionLanes, cellLength(cell(rowBegin, colBegin)));
+        std::fill(highs, highs + kReductionLanes, lows[0]);
+
+        const size_t width = colEnd - colBegin;
+        double lengths[kReductionTile];
+        for (size_t i = rowBegin; i < rowEnd; ++i) {
+            if (layout == MatrixLayout::RowMajor) {
+                const Vector3D* line = matrix[i] + colBegin;
+                size_t j = 0;
+                for (; j + kReductionLanes <= width; j += kReductionLanes)
+                    for (size_t lane = 0; lane < kReductionLanes; ++lane)
+                        lengths[j + lane] = cellLength(line[j + lane]);
+                for (; j < width; ++j)
+                    lengths[j] = cellLength(line[j]);
+            } else {
+                for (size_t j = 0; j < width; ++j)
+                    lengths[j] = cellLength(matrix[colBegin + j][i]);
+            }
+
+            size_t j = 0;
+            for (; j + kReductionLanes <= width; j += kReductionLanes)
+                for (size_t lane = 0; lane < kReductionLanes; ++lane) {
+                    neumaierAdd(sums[lane], compensations[lane], lengths[j + lane]);
+                    lows[lane] = std::min(lows[lane], lengths[j + lane]);
+                    highs[lane] = std::max(highs[lane], lengths[j + lane]);
+                }
+            for (; j < width; ++j) {
+                const size_t lane = j % kReductionLanes;
+                neumaierAdd(sums[lane], compensations[lane], lengths[j]);
+                lows[lane] = std::min(lows[lane], lengths[j]);
+                highs[lane] = std::max(highs[lane], lengths[j]);
+            }
+        }
+
+        NormPartial& partial = partials[tile];
+        partial.sum = CompensatedSum{sums[0], compensations[0]};
+        partial.min = lows[0];
+        partial.max = highs[0];
+        for (size_t lane = 1; lane < kReductionLanes; ++lane) {
+            partial.sum.add(CompensatedSum{sums[lane], compensations[lane]});
+            partial.min = std::min(partial.min, lows[lane]);
+            partial.max = std::max(partial.max, highs[lane]);
+        }
+    };
+
+    if (threadCount == 0)
+        threadCount = rows * cols < kParallelReductionCells
+            ? 1 : std::max<size_t>(1, std::thread::hardware_concurrency());
+
+    // Serial reductions never touch the pool, so small comparisons start no threads
+    if (threadCount == 1 || tileCount == 1) {
+        for (size_t tile = 0; tile < tileCount; ++tile)
+            reduceTile(tile);
+    } else {
+        ReductionPool::instance().run(tileCount, threadCount, reduceTile);
+    }
+
+    // Fixed pairwise tree over the tile partials
+    for (size_t stride = 1; stride < tileCount; stride *= 2)
+        for (size_t i = 0; i + stride < tileCount; i += 2 * stride) {
+            partials[i].sum.add(partials[i + stride].sum);
+            partials[i].min = std::min(partials[i].min, partials[i + stride].min);
+            partials[i].max = std::max(partials[i].max, partials[i + stride].max);
+        }
+
+    return NormReduction{partials[0].sum.value(), partials[0].min, partials[0].max};
+}
+
+size_t DynamicMatrix::reductionThreads() {
+    return ReductionPool::instance().size();
+}
+
+// Helper function to calculate total magnitude of vectors
+double DynamicMatrix::totalMagnitude() const {
+    return reduceNorms().sum;
 }
 
 std::ostream& operator<<(std::ostream& os, const DynamicMatrix& mat) {
     for (size_t i = 0; i < mat.rows; ++i) {
         for (size_t j = 0; j < mat.cols; ++j) {
-            os << mat.matrix[i][j] << " ";
+            os << mat.cell(i, j) << " ";
         }
         os << std::endl;
     }
@@ -294,12 +1094,88 @@ std::ostream& operator<<(std::ostream& os, const DynamicMatrix& mat) {
 std::istream& operator>>(std::istream& is, DynamicMatrix& mat) {
     for (size_t i = 0; i < mat.rows; ++i) {
         for (size_t j = 0; j < mat.cols; ++j) {
-            is >> mat.matrix[i][j].x >> mat.matrix[i][j].y >> mat.matrix[i][j].z;
+            Vector3D& target = mat.cell(i, j);
+            is >> target.x >> target.y >> target.z;
         }
     }
+    mat.markAllDirty();
     return is;
 }
 
+// Staging buffer size for descriptor-based file I/O, each pread/pwrite moves up to this many bytes
+static const size_t kFileIoBytes = 8 << 20;
+
+struct FileDescriptor {
+    int fd;
+
+    explicit FileDescriptor(int fd) : fd(fd) {}
+    ~FileDescriptor() {
+        if (fd >= 0)
+            close(fd);
+    }
+    FileDescriptor(const FileDescriptor&) = delete;
+    FileDescriptor& operator=(const FileDescriptor&) = delete;
+};
+
+static void writeFully(int fd, const char* data, size_t size, off_t offset) {
+    while (size > 0) {
+        const ssize_t written = pwrite(fd, data, size, offset);
+        if (written <= 0)
+            throw std::runtime_error("Unable to write file");
+        data += written;
+        size -= written;
+        offset += written;
+    }
+}
+
+static void syncFile(int fd) {
+    if (fsync(fd) != 0)
+        throw std::runtime_error("Unable to write file");
+}
+
+// Makes a rename into the directory holding path durable
+static void syncDirectory(const std::string& path) {
+    const std::filesystem::path parent = std::filesystem::path(path).parent_path();
+    FileDescriptor dir(open(parent.empty() ? "." : parent.c_str(), O_RDONLY | O_DIRECTORY));
+    if (dir.fd < 0)
+        throw std::runtime_error("Unable to open directory");
+    syncFile(dir.fd);
+}
+
+static const uint64_t kFnvOffset = 14695981039346656037ull;
+static const uint64_t kFnvPrime = 1099511628211ull;
+
+static uint64_t fnv1a(uint64_t hash, const char* data, size_t bytes) {
+    for (size_t i = 0; i < bytes; ++i) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= kFnvPrime;
+    }
+    return hash;
+}
+
+// FNV-1a over whole 64-bit words, eight times fewer multiplies for large images
+static uint64_t fnv1aWords(uint64_t hash, const void* data, size_t bytes) {
+    const char* bytesIn = static_cast<const char*>(data);
+    for (size_t i = 0; i < bytes / sizeof(uint64_t); ++i) {
+        uint64_t word;
+        std::memcpy(&word, bytesIn + i * sizeof(uint64_t), sizeof(word));
+        hash ^= word;
+        hash *= kFnvPrime;
+    }
+    return hash;
+}
+
+// Checksum of the saveToFile image of the matrix, identifies the base of a delta file
+uint64_t DynamicMatrix::contentChecksum() const {
+    const size_t header[2] = {rows, cols};
+    uint64_t hash = fnv1aWords(kFnvOffset, header, sizeof(header));
+    for (size_t i = 0; i < rows; ++i)
+        for (size_t j = 0; j < cols; ++j)
+            hash = fnv1aWords(hash, &cell(i, j), sizeof(Vector3D));
+    return hash;
+}
+
+// The file format is always row-major regardless of the in-memory layout
 void DynamicMatrix::saveToFile(const std::string& filename) const {
     std::ofstream file(filename, std::ios::binary);
     if (!file) {
@@ -311,9 +1187,14 @@ void DynamicMatrix::saveToFile(const std::string& filename) const {
 
     for (size_t i = 0; i < rows; ++i) {
         for (size_t j = 0; j < cols; ++j) {
-            file.write(reinterpret_cast<const char*>(&matrix[i][j]), sizeof(Vector3D));
+            file.write(reinterpret_cast<const char*>(&cell(i, j)), sizeof(Vector3D));
         }
     }
+
+    file.flush();
+    if (!file) {
+        throw std::runtime_error("Unable to write matrix file");
+    }
 }
 
 DynamicMatrix DynamicMatrix::loadFromFile(const std::string& filename) {
@@ -325,6 +1206,9 @@ DynamicMatrix DynamicMatrix::loadFromFile(const std::string& filename) {
     size_t rows, cols;
     file.read(reinterpret_cast<char*>(&rows), sizeof(rows));
     file.read(reinterpret_cast<char*>(&cols), sizeof(cols));
+    if (!file) {
+        throw std::runtime_error("Corrupted matrix file");
+    }
 
     DynamicMatrix result(rows, cols);
 
@@ -333,6 +1217,607 @@ DynamicMatrix DynamicMatrix::loadFromFile(const std::string& filename) {
             file.read(reinterpret_cast<char*>(&result.matrix[i][j]), sizeof(Vector3D));
         }
     }
+    if (!file) {
+        throw std::runtime_error("Corrupted matrix file");
+    }
+
+    result.markClean();
+    result.checkpointBase = result.contentChecksum();
+    return result;
+}
+
+// A delta file is a log of framed records {magic, payload bytes} payload {checksum, end
+// marker}, with an FNV-1a checksum over the payload. Tile records carry a header
+// {base checksum, rows, cols, tile edge, tile count} followed by {tile index, row-major
+// tile cells} for every dirty tile. Base records carry the checksum of a base that
+// saveBase is about to swap in; the records before it are already part of that base.
+static const uint64_t kDeltaMagic = 0x32544c4544584d44ull;  // "DMXDELT2"
+static const uint64_t kBaseMagic = 0x3245534142584d44ull;   // "DMXBASE2"
+static const uint64_t kDeltaEnd = 0x444e4541544c4544ull;    // "DELTAEND"
+static const uint64_t kDeltaFrameBytes = 2 * sizeof(uint64_t);
+static const uint64_t kDeltaTrailerBytes = 2 * sizeof(uint64_t);
+
+struct DeltaFrame {
+    uint64_t magic;
+    uint64_t payloadOffset;
+    uint64_t payloadBytes;
+};
+
+// Records are multiples of 8 bytes long, so any later frame starts on an 8-byte boundary
+static bool frameFollows(std::ifstream& file, uint64_t offset, uint64_t fileSize) {
+    uint64_t words[4096];
+    file.clear();
+    file.seekg(static_cast<std::streamoff>(offset));
+    while (offset + sizeof(uint64_t) <= fileSize) {
+        const size_t count = std::min<uint64_t>(4096, (fileSize - offset) / sizeof(uint64_t));
+        if (!file.read(reinterpret_cast<char*>(words), count * sizeof(uint64_t)))
+            return false;
+        for (size_t i = 0; i < count; ++i)
+            if (words[i] == kDeltaMagic || words[i] == kBaseMagic)
+                return true;
+        offset += count * sizeof(uint64_t);
+    }
+    return false;
+}
+
+// Walks the frames by their headers and end markers only, payloads are checked when
+// they are loaded. Appends always start after the last complete record, so only the
+// last one can be torn: a broken frame with another frame after it is corruption.
+static std::vector<DeltaFrame> scanDeltaFrames(std::ifstream& file, uint64_t fileSize) {
+    std::vector<DeltaFrame> frames;
+    uint64_t offset = 0;
+    while (offset < fileSize) {
+        uint64_t frame[2] = {0, 0};
+        uint64_t endMarker = 0;
+        file.seekg(static_cast<std::streamoff>(offset));
+        bool complete = fileSize - offset >= kDeltaFrameBytes + kDeltaTrailerBytes &&
+                        file.read(reinterpret_cast<char*>(frame), sizeof(frame)) &&
+                        (frame[0] == kDeltaMagic || frame[0] == kBaseMagic) &&
+                        frame[1] <= fileSize - offset - kDeltaFrameBytes - kDeltaTrailerBytes;
+        if (complete) {
+            file.seekg(static_cast<std::streamoff>(offset + kDeltaFrameBytes + frame[1] + sizeof(uint64_t)));
+            complete = file.read(reinterpret_cast<char*>(&endMarker), sizeof(endMarker)) && endMarker == kDeltaEnd;
+        }
+        if (!complete) {
+            if (frameFollows(file, offset + sizeof(uint64_t), fileSize)) {
+                throw std::runtime_error("Corrupted delta file");
+            }
+            break;
+        }
+        frames.push_back(DeltaFrame{frame[0], offset + kDeltaFrameBytes, frame[1]});
+        offset += kDeltaFrameBytes + frame[1] + kDeltaTrailerBytes;
+    }
+    file.clear();
+    return frames;
+}
+
+// Appends one record after the last complete one, dropping a torn record left by an
+// earlier crash. writePayload(put) produces exactly payloadBytes through put; a failed
+// append is cut back off so the log always ends with a complete record.
+template <typename Writer>
+static void appendDeltaRecord(const std::string& filename, uint64_t magic, uint64_t payloadBytes,
+                              Writer writePayload, bool sync) {
+    uint64_t start = 0;
+    {
+        std::ifstream existing(filename, std::ios::binary | std::ios::ate);
+        if (existing) {
+            const uint64_t fileSize = static_cast<uint64_t>(existing.tellg());
+            const std::vector<DeltaFrame> frames = scanDeltaFrames(existing, fileSize);
+            if (!frames.empty())
+                start = frames.back().payloadOffset + frames.back().payloadBytes + kDeltaTrailerBytes;
+        }
+    }
+
+    std::error_code error;
+    {
+        std::ofstream touch(filename, std::ios::binary | std::ios::app);
+        if (!touch) {
+            throw std::runtime_error("Unable to open file for writing");
+        }
+    }
+    std::filesystem::resize_file(filename, start, error);
+    if (error) {
+        throw std::runtime_error("Unable to write delta file");
+    }
+
+    bool written = false;
+    try {
+        std::ofstream file(filename, std::ios::binary | std::ios::app);
+        uint64_t checksum = kFnvOffset;
+        auto put = [&file, &checksum](const void* data, size_t bytes) {
+            checksum = fnv1a(checksum, static_cast<const char*>(data), bytes);
+            file.write(static_cast<const char*>(data), static_cast<std::streamsize>(bytes));
+        };
+
+        const uint64_t frame[2] = {magic, payloadBytes};
+        file.write(reinterpret_cast<const char*>(frame), sizeof(frame));
+        writePayload(put);
+        const uint64_t trailer[2] = {checksum, kDeltaEnd};
+        file.write(reinterpret_cast<const char*>(trailer), sizeof(trailer));
+        file.close();
+        written = !file.fail();
+
+        if (written && sync) {
+            FileDescriptor synced(open(filename.c_str(), O_WRONLY));
+            written = synced.fd >= 0 && fsync(synced.fd) == 0;
+        }
+    } catch (...) {
+        written = false;
+    }
+
+    if (!written) {
+        std::filesystem::resize_file(filename, start, error);
+        if (error) {
+            throw std::runtime_error("Unable to write delta file, and the partial record could not be removed");
+        }
+        throw std::runtime_error("Unable to write delta file");
+    }
+}
+
+void DynamicMatrix::saveDelta(const std::string& filename) {
+    if (checkpointBase == 0) {
+        throw std::runtime_error("No base checkpoint to write deltas against, call saveBase first");
+    }
+
+    const size_t tileCount = tileRowCount() * tileColCount();
+    std::vector<size_t> dirty;
+    uint64_t payloadBytes = 5 * sizeof(uint64_t);
+    for (size_t tile = 0; tile < tileCount; ++tile) {
+        if ((dirtyTiles[tile / 64] >> (tile % 64)) & 1) {
+            dirty.push_back(tile);
+            const size_t rowBegin = (tile / tileColCount()) * kCheckpointTile;
+            const size_t colBegin = (tile % tileColCount()) * kCheckpointTile;
+            payloadBytes += sizeof(size_t) + (std::min(rowBegin + kCheckpointTile, rows) - rowBegin) *
+                                                 (std::min(colBegin + kCheckpointTile, cols) - colBegin) *
+                                                 sizeof(Vector3D);
+        }
+    }
+
+    appendDeltaRecord(filename, kDeltaMagic, payloadBytes, [&](auto& put) {
+        const uint64_t header[5] = {checkpointBase, rows, cols, kCheckpointTile, dirty.size()};
+        put(header, sizeof(header));
+
+        for (size_t tile : dirty) {
+            const size_t rowBegin = (tile / tileColCount()) * kCheckpointTile;
+            const size_t colBegin = (tile % tileColCount()) * kCheckpointTile;
+            const size_t rowEnd = std::min(rowBegin + kCheckpointTile, rows);
+            const size_t colEnd = std::min(colBegin + kCheckpointTile, cols);
+
+            put(&tile, sizeof(tile));
+            for (size_t i = rowBegin; i < rowEnd; ++i) {
+                if (layout == MatrixLayout::RowMajor) {
+                    put(matrix[i] + colBegin, (colEnd - colBegin) * sizeof(Vector3D));
+                } else {
+                    for (size_t j = colBegin; j < colEnd; ++j)
+                        put(&cell(i, j), sizeof(Vector3D));
+                }
+            }
+        }
+    }, false);
+    markClean();
+}
+
+// Crash-safe order: the base record is synced into the delta log first, then the new
+// base is synced and renamed into place, and only once the rename is durable are the
+// now redundant records truncated away. At every point the files on disk load as
+// either the old checkpoint or the new one.
+void DynamicMatrix::saveBase(const std::string& baseFile, const std::string& deltaFile) {
+    const uint64_t baseChecksum = contentChecksum();
+    appendDeltaRecord(deltaFile, kBaseMagic, sizeof(baseChecksum),
+                      [&](auto& put) { put(&baseChecksum, sizeof(baseChecksum)); }, true);
+
+    const std::string tempFile = baseFile + ".tmp";
+    try {
+        FileDescriptor file(open(tempFile.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644));
+        if (file.fd < 0)
+            throw std::runtime_error("Unable to open file for writing");
+
+        const size_t header[2] = {rows, cols};
+        writeFully(file.fd, reinterpret_cast<const char*>(header), sizeof(header), 0);
+
+        const size_t rowBytes = cols * sizeof(Vector3D);
+        const size_t rowsPerChunk = std::max<size_t>(1, kFileIoBytes / std::max<size_t>(rowBytes, 1));
+        std::vector<Vector3D> buffer(std::min(rowsPerChunk, rows) * cols);
+        off_t offset = sizeof(header);
+        for (size_t chunkBegin = 0; chunkBegin < rows; chunkBegin += rowsPerChunk) {
+            const size_t chunkEnd = std::min(chunkBegin + rowsPerChunk, rows);
+            for (size_t i = chunkBegin; i < chunkEnd; ++i)
+                for (size_t j = 0; j < cols; ++j)
+                    buffer[(i - chunkBegin) * cols + j] = cell(i, j);
+            const size_t bytes = (chunkEnd - chunkBegin) * rowBytes;
+            writeFully(file.fd, reinterpret_cast<const char*>(buffer.data()), bytes, offset);
+            offset += bytes;
+        }
+        syncFile(file.fd);
+
+        if (std::rename(tempFile.c_str(), baseFile.c_str()) != 0)
+            throw std::runtime_error("Unable to replace base file");
+    } catch (...) {
+        std::remove(tempFile.c_str());
+        throw;
+    }
+
+    // The new base is live from here on, later failures only leave redundant records
+    // behind, which loadWithDeltas skips and the next saveBase truncates
+    checkpointBase = baseChecksum;
+    markClean();
+    try {
+        syncDirectory(baseFile);
+    } catch (const std::runtime_error&) {
+        return;
+    }
+    std::error_code error;
+    std::filesystem::resize_file(deltaFile, 0, error);
+}
+
+DynamicMatrix DynamicMatrix::loadWithDeltas(const std::string& baseFile, const std::string& deltaFile) {
+    DynamicMatrix result = loadFromFile(baseFile);
+    const uint64_t baseChecksum = result.checkpointBase;
+
+    // A missing delta file just means nothing changed since the base was written
+    std::ifstream file(deltaFile, std::ios::binary | std::ios::ate);
+    if (file) {
+        const uint64_t fileSize = static_cast<uint64_t>(file.tellg());
+        const std::vector<DeltaFrame> frames = scanDeltaFrames(file, fileSize);
+
+        // Payloads are checked before they are used, so a torn last record (the process
+        // died inside an append) is skipped and the result stays at the checkpoint before it
+        std::vector<char> payload;
+        auto readPayload = [&](size_t n) {
+            const DeltaFrame& frame = frames[n];
+            payload.resize(frame.payloadBytes);
+            uint64_t checksum = 0;
+            file.seekg(static_cast<std::streamoff>(frame.payloadOffset));
+            file.read(payload.data(), static_cast<std::streamsize>(payload.size()));
+            file.read(reinterpret_cast<char*>(&checksum), sizeof(checksum));
+            if (file && checksum == fnv1a(kFnvOffset, payload.data(), payload.size()))
+                return true;
+            if (n + 1 == frames.size())
+                return false;
+            throw std::runtime_error("Corrupted delta file");
+        };
+
+        // Records before the newest base record naming this base are already in it
+        size_t first = 0;
+        for (size_t n = 0; n < frames.size(); ++n) {
+            if (frames[n].magic != kBaseMagic || !readPayload(n))
+                continue;
+            uint64_t announced = 0;
+            if (payload.size() == sizeof(announced))
+                std::memcpy(&announced, payload.data(), sizeof(announced));
+            if (announced == baseChecksum)
+                first = n + 1;
+        }
+
+        for (size_t n = first; n < frames.size(); ++n) {
+            // Base records for other bases come from a saveBase that never swapped its base in
+            if (frames[n].magic != kDeltaMagic)
+                continue;
+            if (!readPayload(n))
+                break;
+
+            const char* cursor = payload.data();
+            const char* payloadEnd = cursor + payload.size();
+            auto take = [&cursor, payloadEnd](void* out, size_t bytes) {
+                if (static_cast<size_t>(payloadEnd - cursor) < bytes) {
+                    throw std::runtime_error("Corrupted delta file");
+                }
+                std::memcpy(out, cursor, bytes);
+                cursor += bytes;
+            };
+
+            uint64_t header[5];
+            take(header, sizeof(header));
+            if (header[0] != baseChecksum) {
+                throw std::runtime_error("Delta file was written against a different base file");
+            }
+            if (header[3] != kCheckpointTile) {
+                throw std::runtime_error("Unsupported delta tile size");
+            }
+
+            // Reshaped matrices are fully dirty, so such a record replaces everything
+            if (header[1] != result.rows || header[2] != result.cols) {
+                result = DynamicMatrix(header[1], header[2]);
+                if (header[4] != result.tileRowCount() * result.tileColCount()) {
+                    throw std::runtime_error("Corrupted delta file");
+                }
+            }
+
+            const size_t tileCount = result.tileRowCount() * result.tileColCount();
+            for (size_t count = 0; count < header[4]; ++count) {
+                size_t tile;
+                take(&tile, sizeof(tile));
+                if (tile >= tileCount) {
+                    throw std::runtime_error("Corrupted delta file");
+                }
+
+                const size_t rowBegin = (tile / result.tileColCount()) * kCheckpointTile;
+                const size_t colBegin = (tile % result.tileColCount()) * kCheckpointTile;
+                const size_t rowEnd = std::min(rowBegin + kCheckpointTile, result.rows);
+                const size_t colEnd = std::min(colBegin + kCheckpointTile, result.cols);
+                for (size_t i = rowBegin; i < rowEnd; ++i)
+                    take(result.matrix[i] + colBegin, (colEnd - colBegin) * sizeof(Vector3D));
+            }
+            if (cursor != payloadEnd) {
+                throw std::runtime_error("Corrupted delta file");
+            }
+        }
+    }
+
+    result.markClean();
+    result.checkpointBase = baseChecksum;
+    return result;
+}
+
+void DynamicMatrix::compactDeltas(const std::string& baseFile, const std::string& deltaFile) {
+    DynamicMatrix merged = loadWithDeltas(baseFile, deltaFile);
+    merged.saveBase(baseFile, deltaFile);
+}
+
+static void readFully(int fd, char* data, size_t size, off_t offset) {
+    while (size > 0) {
+        const ssize_t count = pread(fd, data, size, offset);
+        if (count <= 0)
+            throw std::runtime_error("Corrupted shard file");
+        data += count;
+        size -= count;
+        offset += count;
+    }
+}
+
+// Runs task(0..taskCount) on up to threadCount threads, rethrows the first failure
+static void runTasks(size_t taskCount, size_t threadCount, const std::function<void(size_t)>& task) {
+    if (threadCount == 0)
+        threadCount = std::max<size_t>(1, std::thread::hardware_concurrency());
+    threadCount = std::min(threadCount, taskCount);
+
+    std::atomic<size_t> nextTask(0);
+    std::exception_ptr error;
+    std::mutex errorMutex;
+    auto worker = [&]() {
+        for (size_t index = nextTask++; index < taskCount; index = nextTask++) {
+            try {
+                task(index);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (!error)
+                    error = std::current_exception();
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < threadCount; ++i)
+        workers.emplace_back(worker);
+    worker();
+    for (std::thread& thread : workers)
+        thread.join();
+
+    if (error)
+        std::rethrow_exception(error);
+}
+
+static std::string shardFileName(const std::string& manifestFile, size_t generation, size_t shard) {
+    return manifestFile + ".g" + std::to_string(generation) + ".shard" + std::to_string(shard);
+}
+
+// Parses "<manifest name>.g<generation>.shard<i>", returns false for any other name
+static bool parseShardFileName(const std::string& name, const std::string& manifestName, size_t& generation) {
+    const std::string prefix = manifestName + ".g";
+    if (name.compare(0, prefix.size(), prefix) != 0)
+        return false;
+
+    size_t pos = prefix.size();
+    auto digits = [&name, &pos]() {
+        const size_t begin = pos;
+        while (pos < name.size() && name[pos] >= '0' && name[pos] <= '9')
+            ++pos;
+        return pos > begin;
+    };
+    const size_t generationBegin = pos;
+    if (!digits() || name.compare(pos, 6, ".shard") != 0)
+        return false;
+    generation = std::stoull(name.substr(generationBegin, pos - generationBegin));
+    pos += 6;
+    return digits() && pos == name.size();
+}
+
+// Manifest: {rows, cols, generation, shardCount} then {rowBegin, rowEnd} per shard.
+// Shard file: {rowBegin, rowEnd, cols} then the band's cells in row-major order.
+struct ShardManifest {
+    size_t rows = 0;
+    size_t cols = 0;
+    size_t generation = 0;
+    std::vector<std::pair<size_t, size_t>> bands;
+};
+
+static ShardManifest readShardManifest(const std::string& manifestFile) {
+    std::ifstream file(manifestFile, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Unable to open file for reading");
+    }
+
+    ShardManifest manifest;
+    size_t shardCount = 0;
+    file.read(reinterpret_cast<char*>(&manifest.rows), sizeof(manifest.rows));
+    file.read(reinterpret_cast<char*>(&manifest.cols), sizeof(manifest.cols));
+    file.read(reinterpret_cast<char*>(&manifest.generation), sizeof(manifest.generation));
+    file.read(reinterpret_cast<char*>(&shardCount), sizeof(shardCount));
+    if (!file) {
+        throw std::runtime_error("Corrupted shard manifest");
+    }
+
+    size_t expectedBegin = 0;
+    for (size_t shard = 0; shard < shardCount; ++shard) {
+        std::pair<size_t, size_t> band;
+        file.read(reinterpret_cast<char*>(&band.first), sizeof(band.first));
+        file.read(reinterpret_cast<char*>(&band.second), sizeof(band.second));
+        if (!file || band.first != expectedBegin || band.second < band.first) {
+            throw std::runtime_error("Corrupted shard manifest");
+        }
+        expectedBegin = band.second;
+        manifest.bands.push_back(band);
+    }
+    if (expectedBegin != manifest.rows) {
+        throw std::runtime_error("Corrupted shard manifest");
+    }
+    return manifest;
+}
+
+void DynamicMatrix::saveSharded(const std::string& manifestFile, size_t shardCount, size_t threadCount) const {
+    if (shardCount == 0)
+        throw std::invalid_argument("Sharded save needs at least one shard");
+
+    // Each save writes a new generation of shard files next to the current one, so the
+    // manifest on disk keeps pointing at complete shards until it is replaced
+    size_t previousGeneration = 0;
+    try {
+        previousGeneration = readShardManifest(manifestFile).generation;
+    } catch (const std::runtime_error&) {
+    }
+    const size_t generation = previousGeneration + 1;
+
+    const size_t rowBytes = cols * sizeof(Vector3D);
+    const size_t rowsPerChunk = std::max<size_t>(1, kFileIoBytes / std::max<size_t>(rowBytes, 1));
+
+    auto writeShard = [&](size_t shard) {
+        const size_t rowBegin = rows * shard / shardCount;
+        const size_t rowEnd = rows * (shard + 1) / shardCount;
+
+        FileDescriptor file(
+            open(shardFileName(manifestFile, generation, shard).c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644));
+        if (file.fd < 0)
+            throw std::runtime_error("Unable to open file for writing");
+
+        const size_t header[3] = {rowBegin, rowEnd, cols};
+        writeFully(file.fd, reinterpret_cast<const char*>(header), sizeof(header), 0);
+
+        std::vector<Vector3D> buffer(std::min(rowsPerChunk, rowEnd - rowBegin) * cols);
+        off_t offset = sizeof(header);
+        for (size_t chunkBegin = rowBegin; chunkBegin < rowEnd; chunkBegin += rowsPerChunk) {
+            const size_t chunkEnd = std::min(chunkBegin + rowsPerChunk, rowEnd);
+            for (size_t i = chunkBegin; i < chunkEnd; ++i) {
+                Vector3D* out = buffer.data() + (i - chunkBegin) * cols;
+                if (layout == MatrixLayout::RowMajor) {
+                    std::copy(matrix[i], matrix[i] + cols, out);
+                } else {
+                    for (size_t j = 0; j < cols; ++j)
+                        out[j] = matrix[j][i];
+                }
+            }
+            const size_t bytes = (chunkEnd - chunkBegin) * rowBytes;
+            writeFully(file.fd, reinterpret_cast<const char*>(buffer.data()), bytes, offset);
+            offset += bytes;
+        }
+        syncFile(file.fd);
+    };
+
+    // The manifest is written and synced only after every shard is durable, then
+    // renamed over the old one, so after a crash the manifest on disk names either
+    // the previous generation or this one, both complete
+    const std::string tempFile = manifestFile + ".tmp";
+    try {
+        runTasks(shardCount, threadCount, writeShard);
+
+        std::vector<size_t> header = {rows, cols, generation, shardCount};
+        for (size_t shard = 0; shard < shardCount; ++shard) {
+            header.push_back(rows * shard / shardCount);
+            header.push_back(rows * (shard + 1) / shardCount);
+        }
+        FileDescriptor file(open(tempFile.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644));
+        if (file.fd < 0)
+            throw std::runtime_error("Unable to open file for writing");
+        writeFully(file.fd, reinterpret_cast<const char*>(header.data()), header.size() * sizeof(size_t), 0);
+        syncFile(file.fd);
+
+        if (std::rename(tempFile.c_str(), manifestFile.c_str()) != 0)
+            throw std::runtime_error("Unable to replace shard manifest");
+    } catch (...) {
+        std::remove(tempFile.c_str());
+        for (size_t shard = 0; shard < shardCount; ++shard)
+            std::remove(shardFileName(manifestFile, generation, shard).c_str());
+        throw;
+    }
+
+    // The save is committed once the rename succeeded, so nothing below throws. The
+    // previous generation may only go once the rename is durable: if the directory
+    // can't be synced, a crash could bring back the old manifest, so its shards are
+    // kept and the next save removes them.
+    bool renameDurable = true;
+    try {
+        syncDirectory(manifestFile);
+    } catch (const std::runtime_error&) {
+        renameDurable = false;
+    }
+    const std::filesystem::path manifestPath(manifestFile);
+    const std::filesystem::path directory =
+        manifestPath.has_parent_path() ? manifestPath.parent_path() : std::filesystem::path(".");
+
+    // Drop the previous generation, shards past the new count and leftovers of
+    // saves that failed or crashed before their manifest was swapped in
+    std::error_code error;
+    const std::string manifestName = manifestPath.filename().string();
+    std::vector<std::filesystem::path> stale;
+    for (const auto& entry : std::filesystem::directory_iterator(directory, error)) {
+        size_t fileGeneration = 0;
+        if (parseShardFileName(entry.path().filename().string(), manifestName, fileGeneration) &&
+            fileGeneration != generation && (renameDurable || fileGeneration != previousGeneration))
+            stale.push_back(entry.path());
+    }
+    for (const std::filesystem::path& path : stale)
+        std::filesystem::remove(path, error);
+}
+
+DynamicMatrix DynamicMatrix::loadSharded(const std::string& manifestFile, size_t threadCount) {
+    const ShardManifest manifest = readShardManifest(manifestFile);
+    return loadShardedRows(manifestFile, 0, manifest.rows, threadCount);
+}
+
+DynamicMatrix DynamicMatrix::loadShardedRows(const std::string& manifestFile, size_t rowBegin, size_t rowEnd,
+                                             size_t threadCount) {
+    const ShardManifest manifest = readShardManifest(manifestFile);
+    if (rowBegin > rowEnd || rowEnd > manifest.rows)
+        throw std::out_of_range("Row range out of range");
+
+    std::vector<size_t> shards;
+    for (size_t shard = 0; shard < manifest.bands.size(); ++shard)
+        if (manifest.bands[shard].first < rowEnd && manifest.bands[shard].second > rowBegin)
+            shards.push_back(shard);
+
+    const size_t cols = manifest.cols;
+    const size_t rowBytes = cols * sizeof(Vector3D);
+    const size_t rowsPerChunk = std::max<size_t>(1, kFileIoBytes / std::max<size_t>(rowBytes, 1));
+    DynamicMatrix result(rowEnd - rowBegin, cols);
+
+    // Every shard fills its own rows of the result, so workers never share a row
+    runTasks(shards.size(), threadCount, [&](size_t task) {
+        const size_t shard = shards[task];
+        const size_t bandBegin = manifest.bands[shard].first;
+        const size_t bandEnd = manifest.bands[shard].second;
+
+        FileDescriptor file(open(shardFileName(manifestFile, manifest.generation, shard).c_str(), O_RDONLY));
+        if (file.fd < 0)
+            throw std::runtime_error("Unable to open file for reading");
+
+        size_t header[3];
+        readFully(file.fd, reinterpret_cast<char*>(header), sizeof(header), 0);
+        if (header[0] != bandBegin || header[1] != bandEnd || header[2] != cols)
+            throw std::runtime_error("Corrupted shard file");
+
+        const size_t first = std::max(bandBegin, rowBegin);
+        const size_t last = std::min(bandEnd, rowEnd);
+        std::vector<Vector3D> buffer(std::min(rowsPerChunk, last - first) * cols);
+        for (size_t chunkBegin = first; chunkBegin < last; chunkBegin += rowsPerChunk) {
+            const size_t chunkEnd = std::min(chunkBegin + rowsPerChunk, last);
+            const off_t offset = sizeof(header) + (chunkBegin - bandBegin) * rowBytes;
+            readFully(file.fd, reinterpret_cast<char*>(buffer.data()), (chunkEnd - chunkBegin) * rowBytes, offset);
+            for (size_t i = chunkBegin; i < chunkEnd; ++i) {
+                const Vector3D* in = buffer.data() + (i - chunkBegin) * cols;
+                std::copy(in, in + cols, result.matrix[i - rowBegin]);
+            }
+        }
+    });
 
+    result.markClean();
     return result;
 }
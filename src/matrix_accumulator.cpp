@@ -0,0 +1,63 @@
+#include "matrix_accumulator.h"
+#include <cstddef>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+MatrixAccumulator::MatrixAccumulator(DynamicMatrix& target, size_t threadCount, AccumulationMode mode)
+    : target(target), mode(mode), shards(threadCount) {
+    if (threadCount == 0)
+        throw std::invalid_argument("Accumulator needs at least one thread");
+}
+
+void MatrixAccumulator::add(size_t threadIndex, size_t rowIndex, size_t colIndex, const Vector3D& vec) {
+    if (threadIndex >= shards.size())
+        throw std::out_of_range("Thread index out of range");
+
+    if (mode == AccumulationMode::Atomic) {
+        target.atomicAddVectorAt(rowIndex, colIndex, vec);
+        return;
+    }
+
+    // Shards are allocated lazily by their owning thread, so idle threads cost nothing
+    DynamicMatrix& shard = shards[threadIndex];
+    // A shard starts clean, so its dirty tiles are exactly the ones this thread touched
+    // and merging it into the target only marks those
+    if (shard.getRows() != target.getRows() || shard.getCols() != target.getCols()) {
+        shard = DynamicMatrix(target.getRows(), target.getCols(), target.getLayout());
+        shard.markClean();
+    }
+    shard.addVectorAt(rowIndex, colIndex, vec);
+}
+
+void MatrixAccumulator::merge() {
+    if (mode == AccumulationMode::Atomic)
+        return;
+
+    // Pairwise tree reduction: log2(threadCount) rounds, each round in parallel
+    for (size_t stride = 1; stride < shards.size(); stride *= 2) {
+        std::vector<std::thread> workers;
+        for (size_t i = 0; i + stride < shards.size(); i += 2 * stride) {
+            workers.emplace_back([this, i, stride]() {
+                DynamicMatrix& dst = shards[i];
+                DynamicMatrix& src = shards[i + stride];
+                if (src.getRows() == 0 || src.getCols() == 0)
+                    return;
+                // Assignment would mark every tile dirty, so an idle dst is rebuilt clean
+                if (dst.getRows() == 0 || dst.getCols() == 0) {
+                    dst = DynamicMatrix(src.getRows(), src.getCols(), src.getLayout());
+                    dst.markClean();
+                }
+                dst += src;
+                src = DynamicMatrix();
+            });
+        }
+        for (std::thread& worker : workers)
+            worker.join();
+    }
+
+    if (shards[0].getRows() != 0 && shards[0].getCols() != 0)
+        target += shards[0];
+    shards[0] = DynamicMatrix();
+}
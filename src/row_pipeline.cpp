@@ -0,0 +1,206 @@
+#include "row_pipeline.h"
+#include <cstddef>
+#include <fstream>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+Generator<Row> readBinaryRows(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Unable to open file for reading");
+    }
+
+    size_t rows, cols;
+    file.read(reinterpret_cast<char*>(&rows), sizeof(rows));
+    file.read(reinterpret_cast<char*>(&cols), sizeof(cols));
+    if (!file) {
+        throw std::runtime_error("Corrupted matrix file");
+    }
+
+    // The buffer is reused between rows unless a later stage moves it away
+    Row row;
+    for (size_t i = 0; i < rows; ++i) {
+        row.resize(cols);
+        file.read(reinterpret_cast<char*>(row.data()), cols * sizeof(Vector3D));
+        if (!file) {
+            throw std::runtime_error("Corrupted matrix file");
+        }
+        co_yield row;
+    }
+}
+
+Generator<Row> readTextRows(const std::string& filename, size_t cols) {
+    if (cols == 0) {
+        throw std::invalid_argument("Text rows need at least one column");
+    }
+
+    std::ifstream file(filename);
+    if (!file) {
+        throw std::runtime_error("Unable to open file for reading");
+    }
+
+    Row row;
+    while (true) {
+        row.resize(cols);
+        if (!(file >> row[0].x))
+            break;
+        file >> row[0].y >> row[0].z;
+        for (size_t j = 1; j < cols; ++j)
+            file >> row[j].x >> row[j].y >> row[j].z;
+        if (!file) {
+            throw std::runtime_error("Malformed row in text file");
+        }
+        co_yield row;
+    }
+
+    if (!file.eof()) {
+        throw std::runtime_error("Malformed row in text file");
+    }
+}
+
+Generator<Row> matrixRows(const DynamicMatrix& matrix) {
+    Row row;
+    for (size_t i = 0; i < matrix.getRows(); ++i) {
+        row.resize(matrix.getCols());
+        for (size_t j = 0; j < matrix.getCols(); ++j)
+            row[j] = matrix.at(i, j);
+        co_yield row;
+    }
+}
+
+Generator<Row> mapRows(Generator<Row> rows, std::function<void(Row&)> transform) {
+    for (Row& row : rows) {
+        transform(row);
+        co_yield row;
+    }
+}
+
+Generator<Row> mapCells(Generator<Row> rows, std::function<Vector3D(const Vector3D&)> transform) {
+    for (Row& row : rows) {
+        for (Vector3D& vec : row)
+            vec = transform(vec);
+        co_yield row;
+    }
+}
+
+Generator<Row> filterRows(Generator<Row> rows, std::function<bool(const Row&)> predicate) {
+    for (Row& row : rows)
+        if (predicate(row))
+            co_yield row;
+}
+
+Generator<Row> scaleRows(Generator<Row> rows, double scalar) {
+    for (Row& row : rows) {
+        for (Vector3D& vec : row)
+            vec = vec * scalar;
+        co_yield row;
+    }
+}
+
+Generator<Row> runOnThread(Generator<Row> rows, size_t queueCapacity) {
+    BoundedQueue<Row> queue(queueCapacity);
+    std::exception_ptr error;
+
+    // The frame outlives the worker: the guard below closes the queue and joins
+    // it even when the consumer abandons this generator halfway through
+    std::thread worker([&rows, &queue, &error]() {
+        try {
+            for (Row& row : rows)
+                if (!queue.push(std::move(row)))
+                    break;
+        } catch (...) {
+            error = std::current_exception();
+        }
+        queue.close();
+    });
+
+    struct WorkerGuard {
+        BoundedQueue<Row>& queue;
+        std::thread& worker;
+        ~WorkerGuard() {
+            queue.close();
+            if (worker.joinable())
+                worker.join();
+        }
+    } guard{queue, worker};
+
+    Row row;
+    while (queue.pop(row))
+        co_yield row;
+
+    worker.join();
+    if (error)
+        std::rethrow_exception(error);
+}
+
+size_t writeBinaryRows(Generator<Row> rows, const std::string& filename) {
+    std::ofstream file(filename, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Unable to open file for writing");
+    }
+
+    // Same layout as saveToFile; the header is patched once the row count is known
+    size_t count = 0, cols = 0;
+    file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    file.write(reinterpret_cast<const char*>(&cols), sizeof(cols));
+
+    for (Row& row : rows) {
+        if (count == 0)
+            cols = row.size();
+        else if (row.size() != cols)
+            throw std::invalid_argument("Rows in a stream must have the same length");
+        file.write(reinterpret_cast<const char*>(row.data()), cols * sizeof(Vector3D));
+        ++count;
+    }
+
+    file.seekp(0);
+    file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    file.write(reinterpret_cast<const char*>(&cols), sizeof(cols));
+    if (!file) {
+        throw std::runtime_error("Unable to write matrix file");
+    }
+    return count;
+}
+
+size_t writeTextRows(Generator<Row> rows, const std::string& filename) {
+    std::ofstream file(filename);
+    if (!file) {
+        throw std::runtime_error("Unable to open file for writing");
+    }
+    file.precision(17);
+
+    size_t count = 0;
+    for (Row& row : rows) {
+        for (size_t j = 0; j < row.size(); ++j) {
+            if (j != 0)
+                file << ' ';
+            file << row[j].x << ' ' << row[j].y << ' ' << row[j].z;
+        }
+        file << '\n';
+        ++count;
+    }
+
+    if (!file) {
+        throw std::runtime_error("Unable to write matrix file");
+    }
+    return count;
+}
+
+DynamicMatrix collectRows(Generator<Row> rows) {
+    std::vector<Row> buffered;
+    for (Row& row : rows) {
+        if (!buffered.empty() && row.size() != buffered.front().size())
+            throw std::invalid_argument("Rows in a stream must have the same length");
+        buffered.push_back(std::move(row));
+    }
+
+    // The row count is only known at the end, so the buffered rows and the result are
+    // both alive while copying: the peak is about two copies of the matrix
+    const size_t cols = buffered.empty() ? 0 : buffered.front().size();
+    DynamicMatrix result(buffered.size(), cols);
+    for (size_t i = 0; i < buffered.size(); ++i)
+        for (size_t j = 0; j < cols; ++j)
+            result.at(i, j) = buffered[i][j];
+    return result;
+}
@@ -1,6 +1,15 @@
 #define CATCH_CONFIG_MAIN
 #include <catch/catch.hpp>
 #include "dynamic_matrix.h"
+#include <algorithm>
+#include <cmath>
+#include <csignal>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <thread>
+#include <vector>
+#include <sys/resource.h>
 
 TEST_CASE("DynamicMatrix: Edge Cases", "[DynamicMatrix]") {
     SECTION("Empty matrix construction") {
@@ -190,6 +199,158 @@ TEST_CASE("DynamicMatrix Arithmetic Operations", "[DynamicMatrix]") {
     }
 }
 
+TEST_CASE("DynamicMatrix: Transpose", "[DynamicMatrix]") {
+    SECTION("Out-of-place transpose") {
+        DynamicMatrix matrix(37, 21);
+        for (size_t i = 0; i < 37; ++i)
+            for (size_t j = 0; j < 21; ++j)
+                matrix.at(i, j) = Vector3D(i, j, i * 100 + j);
+
+        DynamicMatrix transposed = matrix.transpose();
+        CHECK(transposed.getRows() == 21);
+        CHECK(transposed.getCols() == 37);
+
+        bool allMatch = true;
+        for (size_t i = 0; i < 37; ++i)
+            for (size_t j = 0; j < 21; ++j)
+                allMatch = allMatch && transposed.at(j, i) == matrix.at(i, j);
+        CHECK(allMatch);
+        CHECK(transposed.transpose() == matrix);
+    }
+
+    SECTION("In-place transpose of a square matrix") {
+        DynamicMatrix matrix(45, 45);
+        for (size_t i = 0; i < 45; ++i)
+            for (size_t j = 0; j < 45; ++j)
+                matrix.at(i, j) = Vector3D(i, j, 0);
+
+        DynamicMatrix expected = matrix.transpose();
+        matrix.transposeInPlace();
+        CHECK(matrix == expected);
+
+        DynamicMatrix rectangular(2, 3);
+        CHECK_THROWS_AS(rectangular.transposeInPlace(), const std::invalid_argument&);
+    }
+}
+
+TEST_CASE("DynamicMatrix: Column-major layout", "[DynamicMatrix]") {
+    DynamicMatrix rowMajor(3, 4);
+    for (size_t i = 0; i < 3; ++i)
+        for (size_t j = 0; j < 4; ++j)
+            rowMajor.at(i, j) = Vector3D(i + 1, j + 1, i * j);
+
+    DynamicMatrix colMajor(rowMajor);
+    colMajor.setLayout(MatrixLayout::ColumnMajor);
+
+    SECTION("Layout conversion keeps the contents") {
+        CHECK(colMajor.getLayout() == MatrixLayout::ColumnMajor);
+        CHECK(colMajor == rowMajor);
+        CHECK(colMajor.at(2, 3) == Vector3D(3, 4, 6));
+
+        colMajor.setLayout(MatrixLayout::RowMajor);
+        CHECK(colMajor.getLayout() == MatrixLayout::RowMajor);
+        CHECK(colMajor == rowMajor);
+    }
+
+    SECTION("Row and column edits") {
+        Vector3D newColumn[3] = {Vector3D(7, 7, 7), Vector3D(8, 8, 8), Vector3D(9, 9, 9)};
+        Vector3D newRow[4] = {Vector3D(1, 0, 0), Vector3D(2, 0, 0), Vector3D(3, 0, 0), Vector3D(4, 0, 0)};
+
+        colMajor.insertColumn(1, newColumn);
+        rowMajor.insertColumn(1, newColumn);
+        colMajor.deleteColumn(3);
+        rowMajor.deleteColumn(3);
+        colMajor.insertRow(3, newRow);
+        rowMajor.insertRow(3, newRow);
+        colMajor.deleteRow(0);
+        rowMajor.deleteRow(0);
+
+        CHECK(colMajor.getRows() == 3);
+        CHECK(colMajor.getCols() == 4);
+        CHECK(colMajor == rowMajor);
+        CHECK(colMajor.at(1, 1) == Vector3D(9, 9, 9));
+    }
+
+    SECTION("Mixed-layout arithmetic") {
+        CHECK((colMajor + rowMajor) == rowMajor * 2);
+        CHECK((rowMajor - colMajor) == DynamicMatrix(3, 4));
+        CHECK((colMajor * 3).getLayout() == MatrixLayout::ColumnMajor);
+
+        DynamicMatrix rhs = rowMajor.transpose();
+        DynamicMatrix expected = rowMajor * rhs;
+        DynamicMatrix rhsColMajor(rhs);
+        rhsColMajor.setLayout(MatrixLayout::ColumnMajor);
+
+        CHECK((rowMajor * rhsColMajor) == expected);
+        CHECK((colMajor * rhs) == expected);
+        CHECK((colMajor * rhsColMajor) == expected);
+    }
+
+    SECTION("Transpose and file I/O") {
+        CHECK(colMajor.transpose() == rowMajor.transpose());
+
+        std::string filename = "test_matrix_colmajor.bin";
+        colMajor.saveToFile(filename);
+        DynamicMatrix loaded = DynamicMatrix::loadFromFile(filename);
+        CHECK(loaded == rowMajor);
+        std::remove(filename.c_str());
+    }
+}
+
+TEST_CASE("DynamicMatrix: Strassen multiplication", "[DynamicMatrix]") {
+    const size_t n = 100;
+    DynamicMatrix a(n, n);
+    DynamicMatrix b(n, n, MatrixLayout::ColumnMajor);
+    for (size_t i = 0; i < n; ++i)
+        for (size_t j = 0; j < n; ++j) {
+            a.at(i, j) = Vector3D(double(i % 7) - 3, double(j % 5), double((i * j) % 9) - 4);
+            b.at(i, j) = Vector3D(double((i + 2 * j) % 11) - 5, 1, 1);
+        }
+
+    SECTION("Exact on integer data, for any thread count") {
+        DynamicMatrix expected = a * b;
+        CHECK(a.multiplyStrassen(b, 8, 1) == expected);
+        CHECK(a.multiplyStrassen(b, 8, 3) == expected);
+        CHECK(a.multiplyStrassen(b, 16, 7) == expected);
+    }
+
+    SECTION("Within the documented error bound") {
+        for (size_t i = 0; i < n; ++i)
+            for (size_t j = 0; j < n; ++j) {
+                a.at(i, j) = a.at(i, j) * 0.1 + Vector3D(1.0 / (i + 1), 0, 0);
+                b.at(i, j) = Vector3D(b.at(i, j).x / 3.0, 0, 0);
+            }
+
+        DynamicMatrix classic = a * b;
+        DynamicMatrix fast = a.multiplyStrassen(b, 8);
+        CHECK(fast == a.multiplyStrassen(b, 8, 1));
+
+        // Leaves of 7 on a 112-wide padded problem, max|A| < 1.4, max|B.x| < 1.7. Both
+        // products are off the exact one, so the classic kernel's own n * n * u term is added
+        const double u = 1.0 / 9007199254740992.0;
+        const double strassenBound = (std::pow(112.0 / 7.0, std::log2(12.0)) * (49 + 35) - 5 * 112) * u * 1.4 * 1.7;
+        const double classicBound = double(n) * n * u * 1.4 * 1.7;
+        const double bound = strassenBound + classicBound;
+        double maxError = 0;
+        for (size_t i = 0; i < n; ++i)
+            for (size_t j = 0; j < n; ++j) {
+                const Vector3D diff = fast.at(i, j) - classic.at(i, j);
+                maxError = std::max({maxError, std::fabs(diff.x), std::fabs(diff.y), std::fabs(diff.z)});
+            }
+        CHECK(maxError <= bound);
+    }
+
+    SECTION("Falls back to the classic kernel") {
+        DynamicMatrix tall(6, 4);
+        DynamicMatrix wide(4, 6);
+        tall.at(1, 2) = Vector3D(1, 2, 3);
+        wide.at(2, 5) = Vector3D(2, 0, 0);
+        CHECK(tall.multiplyStrassen(wide, 1) == tall * wide);
+        CHECK(a.multiplyStrassen(b, n) == a * b);
+        CHECK_THROWS_AS(tall.multiplyStrassen(tall), const std::invalid_argument&);
+    }
+}
+
 TEST_CASE("DynamicMatrix Submatrix Insertion", "[DynamicMatrix]") {
     SECTION("Insert submatrix") {
         DynamicMatrix matrix(4, 4);
@@ -244,6 +405,38 @@ TEST_CASE("DynamicMatrix: addVectorAt") {
     REQUIRE(matrix.at(1, 1).z == 3.0);
 }
 
+TEST_CASE("DynamicMatrix: operator+=", "[DynamicMatrix]") {
+    DynamicMatrix matrix1(2, 2);
+    matrix1.at(0, 1) = Vector3D(1, 2, 3);
+    DynamicMatrix matrix2(2, 2);
+    matrix2.at(0, 1) = Vector3D(1, 1, 1);
+
+    matrix1 += matrix2;
+    CHECK(matrix1.at(0, 1) == Vector3D(2, 3, 4));
+
+    DynamicMatrix matrix3(3, 2);
+    CHECK_THROWS_AS(matrix1 += matrix3, const std::invalid_argument&);
+
+    SECTION("Only changed tiles become dirty") {
+        DynamicMatrix target(150, 150);
+        target.markClean();
+
+        DynamicMatrix written(150, 150);
+        written.markClean();
+        written.addVectorAt(70, 70, Vector3D(1, 1, 1));
+        target += written;
+        CHECK(target.dirtyTileCount() == 1);
+
+        // A clean source can still hold values, e.g. one loaded from a file
+        DynamicMatrix loaded(150, 150);
+        loaded.at(140, 140) = Vector3D(0, 0, 1);
+        loaded.markClean();
+        target += loaded;
+        CHECK(target.dirtyTileCount() == 2);
+        CHECK(target.at(140, 140).z == 1);
+    }
+}
+
 TEST_CASE("DynamicMatrix: Comparison Operators") {
     DynamicMatrix matrix1(2, 2);
     DynamicMatrix matrix2(2, 2);
@@ -264,6 +457,100 @@ TEST_CASE("DynamicMatrix: Comparison Operators") {
     REQUIRE(matrix1 >= matrix3);
 }
 
+TEST_CASE("DynamicMatrix: Norm reductions", "[DynamicMatrix]") {
+    SECTION("Sum, min and max") {
+        DynamicMatrix matrix(2, 2);
+        matrix.at(0, 0) = Vector3D(3, 4, 0);
+        matrix.at(0, 1) = Vector3D(0, 0, 2);
+        matrix.at(1, 0) = Vector3D(1, 0, 0);
+        matrix.at(1, 1) = Vector3D(0, 6, 8);
+
+        NormReduction norms = matrix.reduceNorms();
+        CHECK(norms.sum == 18);
+        CHECK(norms.min == 1);
+        CHECK(norms.max == 10);
+        CHECK(matrix.totalMagnitude() == 18);
+
+        NormReduction empty = DynamicMatrix().reduceNorms();
+        CHECK(empty.sum == 0);
+        CHECK(empty.max == 0);
+    }
+
+    SECTION("Compensated summation") {
+        DynamicMatrix matrix(1, 1001);
+        matrix.at(0, 0) = Vector3D(1e16, 0, 0);
+        for (size_t j = 1; j < 1001; ++j)
+            matrix.at(0, j) = Vector3D(0, 1, 0);
+
+        CHECK(matrix.totalMagnitude() == 1e16 + 1000);
+    }
+
+    SECTION("Result does not depend on the thread count or layout") {
+        DynamicMatrix matrix(150, 97);
+        for (size_t i = 0; i < 150; ++i)
+            for (size_t j = 0; j < 97; ++j)
+                matrix.at(i, j) = Vector3D(0.1 * i, 1.0 / (j + 1), 1e-3 * (i ^ j));
+
+        NormReduction serial = matrix.reduceNorms(1);
+        DynamicMatrix colMajor(matrix);
+        colMajor.setLayout(MatrixLayout::ColumnMajor);
+
+        for (size_t threads : {2, 3, 7, 64}) {
+            NormReduction parallel = matrix.reduceNorms(threads);
+            CHECK(parallel.sum == serial.sum);
+            CHECK(parallel.min == serial.min);
+            CHECK(parallel.max == serial.max);
+            CHECK(colMajor.reduceNorms(threads).sum == serial.sum);
+        }
+    }
+
+    SECTION("Explicit thread counts run on pool helpers") {
+        DynamicMatrix matrix(200, 200);
+        for (size_t i = 0; i < 200; ++i)
+            for (size_t j = 0; j < 200; ++j)
+                matrix.at(i, j) = Vector3D(1.0 / (i + 1), 0.25 * j, i ^ j);
+
+        const size_t before = DynamicMatrix::reductionThreads();
+        CHECK(matrix.reduceNorms(1).sum == matrix.reduceNorms(1).sum);
+        CHECK(DynamicMatrix::reductionThreads() == before);
+
+        const NormReduction serial = matrix.reduceNorms(1);
+        const NormReduction parallel = matrix.reduceNorms(8);
+        CHECK(DynamicMatrix::reductionThreads() >= 7);
+        CHECK(parallel.sum == serial.sum);
+        CHECK(parallel.min == serial.min);
+        CHECK(parallel.max == serial.max);
+
+        // Concurrent callers with helpers available: one takes the pool, the rest run inline
+        std::vector<double> results(4);
+        std::vector<std::thread> callers;
+        for (size_t t = 0; t < results.size(); ++t)
+            callers.emplace_back([&matrix, &results, t]() { results[t] = matrix.reduceNorms(8).sum; });
+        for (std::thread& caller : callers)
+            caller.join();
+        for (double result : results)
+            CHECK(result == serial.sum);
+    }
+
+    SECTION("Concurrent callers share the pool") {
+        DynamicMatrix matrix(300, 300);
+        for (size_t i = 0; i < 300; ++i)
+            for (size_t j = 0; j < 300; ++j)
+                matrix.at(i, j) = Vector3D(1.0 / (i + 1), 0.5 * j, 3);
+
+        const double expected = matrix.reduceNorms(1).sum;
+        std::vector<double> results(4);
+        std::vector<std::thread> callers;
+        for (size_t t = 0; t < results.size(); ++t)
+            callers.emplace_back([&matrix, &results, t]() { results[t] = matrix.totalMagnitude(); });
+        for (std::thread& caller : callers)
+            caller.join();
+
+        for (double result : results)
+            CHECK(result == expected);
+    }
+}
+
 TEST_CASE("DynamicMatrix: Move Constructor and Assignment Operator", "[DynamicMatrix]") {
     DynamicMatrix matrix1(2, 2);
     matrix1.at(0, 0) = Vector3D(1, 2, 3);
@@ -285,6 +572,270 @@ TEST_CASE("DynamicMatrix: Move Constructor and Assignment Operator", "[DynamicMa
     CHECK(matrix2.getCols() == 0);
 }
 
+TEST_CASE("DynamicMatrix: Delta checkpointing", "[DynamicMatrix]") {
+    std::string baseFile = "test_checkpoint_base.bin";
+    std::string deltaFile = "test_checkpoint_delta.bin";
+    std::remove(deltaFile.c_str());
+
+    DynamicMatrix matrix(150, 130);
+    for (size_t i = 0; i < 150; ++i)
+        for (size_t j = 0; j < 130; ++j)
+            matrix.addItem(i, j, Vector3D(i, j, 1));
+
+    matrix.saveBase(baseFile, deltaFile);
+    CHECK(matrix.dirtyTileCount() == 0);
+    CHECK(std::filesystem::file_size(deltaFile) == 0);
+
+    SECTION("Only written tiles are dirty") {
+        matrix.addVectorAt(0, 0, Vector3D(1, 1, 1));
+        matrix.addItem(70, 70, Vector3D(5, 5, 5));
+        matrix.atomicAddVectorAt(149, 129, Vector3D(2, 2, 2));
+        CHECK(matrix.dirtyTileCount() == 3);
+
+        DynamicMatrix submatrix(2, 2);
+        matrix.insertSubmatrix(submatrix, 63, 63);
+        CHECK(matrix.dirtyTileCount() == 5);
+
+        const DynamicMatrix& readOnly = matrix;
+        CHECK(readOnly.at(140, 0).x == 140);
+        CHECK(matrix.at(140, 0).x == 140);
+        CHECK(matrix.dirtyTileCount() == 5);
+
+        matrix.at(140, 0) = Vector3D(9, 9, 9);
+        matrix.markRegionDirty(140, 141, 0, 1);
+        CHECK(matrix.dirtyTileCount() == 6);
+    }
+
+    SECTION("Replay base plus deltas") {
+        matrix.addVectorAt(3, 4, Vector3D(1, 1, 1));
+        matrix.saveDelta(deltaFile);
+        CHECK(matrix.dirtyTileCount() == 0);
+
+        matrix.addItem(100, 120, Vector3D(-1, -2, -3));
+        matrix.deleteItem(64, 0);
+        matrix.saveDelta(deltaFile);
+
+        DynamicMatrix restored = DynamicMatrix::loadWithDeltas(baseFile, deltaFile);
+        CHECK(restored == matrix);
+        CHECK(restored.dirtyTileCount() == 0);
+
+        DynamicMatrix::compactDeltas(baseFile, deltaFile);
+        CHECK(DynamicMatrix::loadFromFile(baseFile) == matrix);
+        CHECK(DynamicMatrix::loadWithDeltas(baseFile, deltaFile) == matrix);
+    }
+
+    SECTION("Assignment marks the whole target dirty") {
+        DynamicMatrix other(150, 130);
+        other.addItem(5, 5, Vector3D(1, 2, 3));
+        std::string otherFile = "test_checkpoint_other.bin";
+        other.saveToFile(otherFile);
+
+        matrix = DynamicMatrix::loadFromFile(otherFile);
+        CHECK(matrix.dirtyTileCount() == 9);
+        matrix.saveDelta(deltaFile);
+        CHECK(DynamicMatrix::loadWithDeltas(baseFile, deltaFile) == other);
+
+        DynamicMatrix copy(other);
+        copy.markClean();
+        matrix.saveBase(baseFile, deltaFile);
+        matrix = copy;
+        CHECK(matrix.dirtyTileCount() == 9);
+
+        matrix.markClean();
+        matrix.setLayout(MatrixLayout::ColumnMajor);
+        CHECK(matrix.dirtyTileCount() == 0);
+        std::remove(otherFile.c_str());
+    }
+
+    SECTION("Shape changes are checkpointed in full") {
+        matrix.deleteRow(10);
+        Vector3D newColumn[149];
+        matrix.insertColumn(0, newColumn);
+        matrix.setLayout(MatrixLayout::ColumnMajor);
+        matrix.saveDelta(deltaFile);
+
+        DynamicMatrix restored = DynamicMatrix::loadWithDeltas(baseFile, deltaFile);
+        CHECK(restored.getRows() == 149);
+        CHECK(restored.getCols() == 131);
+        CHECK(restored == matrix);
+    }
+
+    SECTION("Missing and corrupted delta files") {
+        std::remove(deltaFile.c_str());
+        CHECK(DynamicMatrix::loadWithDeltas(baseFile, deltaFile) == matrix);
+
+        // Damage in a record that is followed by another one is not a torn tail
+        matrix.addItem(10, 10, Vector3D(7, 7, 7));
+        matrix.saveDelta(deltaFile);
+        matrix.addItem(100, 100, Vector3D(8, 8, 8));
+        matrix.saveDelta(deltaFile);
+        const auto size = std::filesystem::file_size(deltaFile);
+        auto damage = [&deltaFile](std::streamoff offset, char byte) {
+            std::fstream damaged(deltaFile, std::ios::binary | std::ios::in | std::ios::out);
+            damaged.seekp(offset);
+            char original = 0;
+            damaged.seekg(offset);
+            damaged.get(original);
+            damaged.seekp(offset);
+            damaged.put(byte);
+            return original;
+        };
+
+        // A tile cell, the payload checksum catches it
+        char original = damage(64, '!');
+        CHECK_THROWS_AS(DynamicMatrix::loadWithDeltas(baseFile, deltaFile), const std::runtime_error&);
+        damage(64, original);
+
+        // The high byte of the first record's length and then its magic: the frame can't
+        // be walked, but another record follows, so neither loading nor appending may
+        // treat it as a torn tail and drop what comes after
+        for (std::streamoff offset : {15, 0}) {
+            original = damage(offset, '\x7f');
+            CHECK_THROWS_AS(DynamicMatrix::loadWithDeltas(baseFile, deltaFile), const std::runtime_error&);
+            matrix.addItem(20, 20, Vector3D(1, 1, 1));
+            CHECK_THROWS_AS(matrix.saveDelta(deltaFile), const std::runtime_error&);
+            CHECK(std::filesystem::file_size(deltaFile) == size);
+            damage(offset, original);
+        }
+        CHECK(DynamicMatrix::loadWithDeltas(baseFile, deltaFile).at(100, 100) == matrix.at(100, 100));
+    }
+
+    SECTION("Deltas are tied to their base") {
+        matrix.addItem(0, 0, Vector3D(1, 1, 1));
+        matrix.saveDelta(deltaFile);
+        matrix.addItem(0, 0, Vector3D(2, 2, 2));
+
+        // A plain saveToFile starts no new delta chain, the old records don't apply to it
+        matrix.saveToFile(baseFile);
+        matrix.markClean();
+        CHECK_THROWS_AS(DynamicMatrix::loadWithDeltas(baseFile, deltaFile), const std::runtime_error&);
+
+        matrix.saveBase(baseFile, deltaFile);
+        CHECK(std::filesystem::file_size(deltaFile) == 0);
+        CHECK(DynamicMatrix::loadWithDeltas(baseFile, deltaFile) == matrix);
+
+        DynamicMatrix unsaved(2, 2);
+        CHECK_THROWS_AS(unsaved.saveDelta(deltaFile), const std::runtime_error&);
+    }
+
+    SECTION("An interrupted saveBase keeps a loadable checkpoint") {
+        matrix.addItem(10, 10, Vector3D(7, 7, 7));
+        matrix.saveDelta(deltaFile);
+        DynamicMatrix first = matrix;
+        matrix.addItem(100, 100, Vector3D(8, 8, 8));
+
+        // The temporary base can't be created, so saveBase fails after logging its base record
+        const std::string blocker = baseFile + ".tmp";
+        std::filesystem::create_directory(blocker);
+        std::ofstream(blocker + "/keep") << "x";
+        CHECK_THROWS_AS(matrix.saveBase(baseFile, deltaFile), const std::runtime_error&);
+        CHECK(matrix.dirtyTileCount() == 1);
+        CHECK(DynamicMatrix::loadWithDeltas(baseFile, deltaFile) == first);
+
+        // A crash after the new base is renamed in but before the log is truncated
+        std::ifstream logIn(deltaFile, std::ios::binary);
+        const std::string log((std::istreambuf_iterator<char>(logIn)), std::istreambuf_iterator<char>());
+        logIn.close();
+        std::filesystem::remove_all(blocker);
+        matrix.saveBase(baseFile, deltaFile);
+        std::ofstream(deltaFile, std::ios::binary) << log;
+        CHECK(DynamicMatrix::loadWithDeltas(baseFile, deltaFile) == matrix);
+
+        matrix.addItem(140, 0, Vector3D(1, 2, 3));
+        matrix.saveDelta(deltaFile);
+        CHECK(DynamicMatrix::loadWithDeltas(baseFile, deltaFile) == matrix);
+    }
+
+    SECTION("A failed compaction keeps the committed data") {
+        matrix.addItem(10, 10, Vector3D(3, 3, 3));
+        matrix.saveDelta(deltaFile);
+        const auto baseSize = std::filesystem::file_size(baseFile);
+
+        // Room for the base record in the delta file but not for the new base
+        rlimit previous;
+        getrlimit(RLIMIT_FSIZE, &previous);
+        auto previousHandler = std::signal(SIGXFSZ, SIG_IGN);
+        rlimit capped = previous;
+        capped.rlim_cur = std::filesystem::file_size(deltaFile) + 1000;
+        setrlimit(RLIMIT_FSIZE, &capped);
+
+        CHECK_THROWS_AS(DynamicMatrix::compactDeltas(baseFile, deltaFile), const std::runtime_error&);
+
+        setrlimit(RLIMIT_FSIZE, &previous);
+        std::signal(SIGXFSZ, previousHandler);
+
+        CHECK(std::filesystem::file_size(baseFile) == baseSize);
+        CHECK_FALSE(std::filesystem::exists(baseFile + ".tmp"));
+        CHECK(DynamicMatrix::loadWithDeltas(baseFile, deltaFile) == matrix);
+
+        DynamicMatrix::compactDeltas(baseFile, deltaFile);
+        CHECK(std::filesystem::file_size(deltaFile) == 0);
+        CHECK(DynamicMatrix::loadFromFile(baseFile) == matrix);
+    }
+
+    SECTION("A torn last record is ignored") {
+        matrix.addItem(10, 10, Vector3D(7, 7, 7));
+        matrix.saveDelta(deltaFile);
+        DynamicMatrix checkpoint = matrix;
+
+        // A crash inside saveDelta leaves a prefix of the next record behind
+        matrix.addItem(100, 100, Vector3D(8, 8, 8));
+        matrix.saveDelta(deltaFile);
+        const auto fullSize = std::filesystem::file_size(deltaFile);
+        std::filesystem::resize_file(deltaFile, fullSize - 100);
+        CHECK(DynamicMatrix::loadWithDeltas(baseFile, deltaFile) == checkpoint);
+
+        // A last frame whose tail was never written is torn as well
+        std::filesystem::resize_file(deltaFile, fullSize);
+        CHECK(DynamicMatrix::loadWithDeltas(baseFile, deltaFile) == checkpoint);
+
+        std::ofstream(deltaFile, std::ios::binary | std::ios::app) << "xyz";
+        CHECK(DynamicMatrix::loadWithDeltas(baseFile, deltaFile) == checkpoint);
+    }
+
+    SECTION("Appends after a torn record still load") {
+        matrix.addItem(10, 10, Vector3D(7, 7, 7));
+        matrix.saveDelta(deltaFile);
+        std::ofstream(deltaFile, std::ios::binary | std::ios::app) << "partial record";
+
+        matrix.addItem(140, 0, Vector3D(1, 2, 3));
+        matrix.saveDelta(deltaFile);
+        CHECK(DynamicMatrix::loadWithDeltas(baseFile, deltaFile) == matrix);
+    }
+
+    SECTION("A failed append is truncated back") {
+        matrix.addItem(10, 10, Vector3D(7, 7, 7));
+        matrix.saveDelta(deltaFile);
+        DynamicMatrix checkpoint = matrix;
+        const auto size = std::filesystem::file_size(deltaFile);
+
+        // Cap the file size so the next record only partly fits
+        rlimit previous;
+        getrlimit(RLIMIT_FSIZE, &previous);
+        auto previousHandler = std::signal(SIGXFSZ, SIG_IGN);
+        rlimit capped = previous;
+        capped.rlim_cur = size + 1000;
+        setrlimit(RLIMIT_FSIZE, &capped);
+
+        matrix.markAllDirty();
+        CHECK_THROWS_AS(matrix.saveDelta(deltaFile), const std::runtime_error&);
+
+        setrlimit(RLIMIT_FSIZE, &previous);
+        std::signal(SIGXFSZ, previousHandler);
+
+        CHECK(std::filesystem::file_size(deltaFile) == size);
+        CHECK(matrix.dirtyTileCount() == 9);
+        CHECK(DynamicMatrix::loadWithDeltas(baseFile, deltaFile) == checkpoint);
+
+        matrix.addItem(0, 0, Vector3D(1, 1, 1));
+        matrix.saveDelta(deltaFile);
+        CHECK(DynamicMatrix::loadWithDeltas(baseFile, deltaFile) == matrix);
+    }
+
+    std::remove(baseFile.c_str());
+    std::remove(deltaFile.c_str());
+}
+
 TEST_CASE("DynamicMatrix: File I/O Operations", "[DynamicMatrix]") {
     DynamicMatrix matrix(2, 2);
     matrix.at(0, 0) = Vector3D(1, 2, 3);
@@ -313,3 +864,84 @@ TEST_CASE("DynamicMatrix: File I/O Operations", "[DynamicMatrix]") {
         CHECK_THROWS_AS(DynamicMatrix::loadFromFile(nonExistentFile), const std::runtime_error&);
     }
 }
+
+TEST_CASE("DynamicMatrix: Sharded file I/O", "[DynamicMatrix]") {
+    std::string manifest = "test_sharded.manifest";
+    const size_t shardCount = 4;
+    auto shardFile = [&manifest](size_t generation, size_t shard) {
+        return manifest + ".g" + std::to_string(generation) + ".shard" + std::to_string(shard);
+    };
+
+    DynamicMatrix matrix(30, 5, MatrixLayout::ColumnMajor);
+    for (size_t i = 0; i < 30; ++i)
+        for (size_t j = 0; j < 5; ++j)
+            matrix.at(i, j) = Vector3D(i, j, i * 5 + j);
+
+    matrix.saveSharded(manifest, shardCount, 3);
+
+    SECTION("Load all shards") {
+        CHECK(DynamicMatrix::loadSharded(manifest, 1) == matrix);
+        CHECK(DynamicMatrix::loadSharded(manifest, 8) == matrix);
+    }
+
+    SECTION("Load a subset of row bands") {
+        DynamicMatrix rows = DynamicMatrix::loadShardedRows(manifest, 5, 17, 2);
+        CHECK(rows.getRows() == 12);
+        CHECK(rows.getCols() == 5);
+        CHECK(rows.at(0, 0) == matrix.at(5, 0));
+        CHECK(rows.at(11, 4) == matrix.at(16, 4));
+
+        // Rows 0..7 live in the first shard only, the others may be missing
+        std::remove(shardFile(1, 3).c_str());
+        CHECK(DynamicMatrix::loadShardedRows(manifest, 0, 7).at(6, 1) == matrix.at(6, 1));
+        CHECK_THROWS_AS(DynamicMatrix::loadSharded(manifest), const std::runtime_error&);
+
+        CHECK(DynamicMatrix::loadShardedRows(manifest, 4, 4).getRows() == 0);
+        CHECK_THROWS_AS(DynamicMatrix::loadShardedRows(manifest, 10, 31), const std::out_of_range&);
+    }
+
+    SECTION("Saving again replaces the previous generation") {
+        // Leftover of a save that crashed before its manifest was swapped in
+        std::ofstream(shardFile(7, 0)) << "partial";
+
+        DynamicMatrix changed = matrix;
+        changed.at(20, 3) = Vector3D(-1, -1, -1);
+        changed.saveSharded(manifest, 2);
+        CHECK(DynamicMatrix::loadSharded(manifest) == changed);
+
+        CHECK(std::filesystem::exists(shardFile(2, 0)));
+        CHECK(std::filesystem::exists(shardFile(2, 1)));
+        CHECK_FALSE(std::filesystem::exists(shardFile(2, 2)));
+        CHECK_FALSE(std::filesystem::exists(shardFile(1, 0)));
+        CHECK_FALSE(std::filesystem::exists(shardFile(1, 3)));
+        CHECK_FALSE(std::filesystem::exists(shardFile(7, 0)));
+        CHECK_FALSE(std::filesystem::exists(manifest + ".tmp"));
+    }
+
+    SECTION("A failed save leaves the previous one loadable") {
+        // A directory in the way makes opening the next generation's second shard fail
+        std::filesystem::create_directory(shardFile(2, 1));
+        std::ofstream(shardFile(2, 1) + "/keep") << "x";
+
+        DynamicMatrix changed = matrix;
+        changed.at(0, 0) = Vector3D(-1, -1, -1);
+        CHECK_THROWS_AS(changed.saveSharded(manifest, shardCount), const std::runtime_error&);
+        CHECK(DynamicMatrix::loadSharded(manifest) == matrix);
+        CHECK_FALSE(std::filesystem::exists(shardFile(2, 0)));
+
+        std::filesystem::remove_all(shardFile(2, 1));
+        changed.saveSharded(manifest, shardCount);
+        CHECK(DynamicMatrix::loadSharded(manifest) == changed);
+    }
+
+    SECTION("Failures") {
+        CHECK_THROWS_AS(matrix.saveSharded(manifest, 0), const std::invalid_argument&);
+        CHECK_THROWS_AS(matrix.saveSharded("/invalid/path/test_sharded.manifest", 2), const std::runtime_error&);
+        CHECK_THROWS_AS(DynamicMatrix::loadSharded("non_existent.manifest"), const std::runtime_error&);
+    }
+
+    std::remove(manifest.c_str());
+    for (size_t generation = 1; generation <= 3; ++generation)
+        for (size_t shard = 0; shard < shardCount; ++shard)
+            std::remove(shardFile(generation, shard).c_str());
+}
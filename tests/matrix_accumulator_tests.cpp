@@ -0,0 +1,90 @@
+#include <catch/catch.hpp>
+#include "matrix_accumulator.h"
+#include <thread>
+#include <vector>
+
+static void scatter(MatrixAccumulator& accumulator, size_t threadCount, size_t addsPerThread) {
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < threadCount; ++t) {
+        threads.emplace_back([&accumulator, t, addsPerThread]() {
+            for (size_t n = 0; n < addsPerThread; ++n)
+                accumulator.add(t, n % 3, (n / 3) % 3, Vector3D(1, 2, 3));
+        });
+    }
+    for (std::thread& thread : threads)
+        thread.join();
+}
+
+TEST_CASE("MatrixAccumulator: Concurrent scatter-add", "[MatrixAccumulator]") {
+    const size_t threadCount = 8;
+    const size_t addsPerThread = 9000;
+
+    SECTION("Atomic mode") {
+        DynamicMatrix matrix(3, 3);
+        MatrixAccumulator accumulator(matrix, threadCount, AccumulationMode::Atomic);
+        scatter(accumulator, threadCount, addsPerThread);
+        accumulator.merge();
+
+        for (size_t i = 0; i < 3; ++i)
+            for (size_t j = 0; j < 3; ++j)
+                CHECK(matrix.at(i, j) == Vector3D(8000, 16000, 24000));
+    }
+
+    SECTION("Sharded mode") {
+        DynamicMatrix matrix(3, 3);
+        matrix.at(0, 0) = Vector3D(1, 1, 1);
+        MatrixAccumulator accumulator(matrix, threadCount, AccumulationMode::Sharded);
+        scatter(accumulator, threadCount, addsPerThread);
+
+        CHECK(matrix.at(1, 1) == Vector3D(0, 0, 0));
+        accumulator.merge();
+
+        CHECK(matrix.at(0, 0) == Vector3D(8001, 16001, 24001));
+        CHECK(matrix.at(2, 2) == Vector3D(8000, 16000, 24000));
+
+        accumulator.merge();
+        CHECK(matrix.at(2, 2) == Vector3D(8000, 16000, 24000));
+    }
+
+    SECTION("64 threads in both modes") {
+        for (AccumulationMode mode : {AccumulationMode::Atomic, AccumulationMode::Sharded}) {
+            DynamicMatrix matrix(3, 3);
+            MatrixAccumulator accumulator(matrix, 64, mode);
+            scatter(accumulator, 64, 900);
+            accumulator.merge();
+
+            for (size_t i = 0; i < 3; ++i)
+                for (size_t j = 0; j < 3; ++j)
+                    CHECK(matrix.at(i, j) == Vector3D(6400, 12800, 19200));
+        }
+    }
+
+    SECTION("Sharded mode with idle threads") {
+        DynamicMatrix matrix(2, 2);
+        MatrixAccumulator accumulator(matrix, 5, AccumulationMode::Sharded);
+        accumulator.add(3, 1, 0, Vector3D(1, 0, 0));
+        accumulator.merge();
+        CHECK(matrix.at(1, 0).x == 1);
+    }
+
+    SECTION("Merging only dirties the touched tiles") {
+        DynamicMatrix matrix(200, 200);
+        matrix.markClean();
+        MatrixAccumulator accumulator(matrix, 4, AccumulationMode::Sharded);
+        accumulator.add(0, 1, 1, Vector3D(1, 0, 0));
+        accumulator.add(2, 150, 150, Vector3D(0, 1, 0));
+        accumulator.add(3, 150, 151, Vector3D(0, 0, 1));
+        accumulator.merge();
+
+        CHECK(matrix.dirtyTileCount() == 2);
+        CHECK(matrix.at(150, 151).z == 1);
+    }
+
+    SECTION("Invalid indices") {
+        DynamicMatrix matrix(2, 2);
+        MatrixAccumulator accumulator(matrix, 2, AccumulationMode::Sharded);
+        CHECK_THROWS_AS(accumulator.add(2, 0, 0, Vector3D()), const std::out_of_range&);
+        CHECK_THROWS_AS(accumulator.add(0, 2, 0, Vector3D()), const std::out_of_range&);
+        CHECK_THROWS_AS(MatrixAccumulator(matrix, 0), const std::invalid_argument&);
+    }
+}
@@ -0,0 +1,81 @@
+#include <catch/catch.hpp>
+#include "row_pipeline.h"
+#include <cstdio>
+#include <fstream>
+
+static DynamicMatrix makeMatrix(size_t rows, size_t cols) {
+    DynamicMatrix matrix(rows, cols);
+    for (size_t i = 0; i < rows; ++i)
+        for (size_t j = 0; j < cols; ++j)
+            matrix.at(i, j) = Vector3D(i, j, i * cols + j);
+    return matrix;
+}
+
+TEST_CASE("RowPipeline: Binary transform-and-write", "[RowPipeline]") {
+    DynamicMatrix matrix = makeMatrix(50, 7);
+    std::string input = "test_pipeline_in.bin";
+    std::string output = "test_pipeline_out.bin";
+    matrix.saveToFile(input);
+
+    SECTION("Stages on one thread") {
+        size_t written = writeBinaryRows(
+            scaleRows(filterRows(readBinaryRows(input),
+                                 [](const Row& row) { return static_cast<size_t>(row[0].x) % 2 == 0; }),
+                      2.0),
+            output);
+        CHECK(written == 25);
+
+        DynamicMatrix loaded = DynamicMatrix::loadFromFile(output);
+        CHECK(loaded.getRows() == 25);
+        CHECK(loaded.getCols() == 7);
+        CHECK(loaded.at(3, 4) == matrix.at(6, 4) * 2);
+    }
+
+    SECTION("Stages on separate threads") {
+        Generator<Row> rows = runOnThread(readBinaryRows(input), 4);
+        rows = runOnThread(mapCells(std::move(rows), [](const Vector3D& vec) { return -vec; }), 2);
+        rows = mapRows(std::move(rows), [](Row& row) { row[0] = Vector3D(1, 1, 1); });
+
+        DynamicMatrix collected = collectRows(std::move(rows));
+        DynamicMatrix expected = matrix * -1.0;
+        for (size_t i = 0; i < 50; ++i)
+            expected.at(i, 0) = Vector3D(1, 1, 1);
+        CHECK(collected == expected);
+    }
+
+    SECTION("Abandoning a threaded stage early") {
+        Generator<Row> rows = runOnThread(readBinaryRows(input), 1);
+        size_t seen = 0;
+        for (Row& row : rows) {
+            CHECK(row.size() == 7);
+            if (++seen == 3)
+                break;
+        }
+        CHECK(seen == 3);
+    }
+
+    std::remove(input.c_str());
+    std::remove(output.c_str());
+}
+
+TEST_CASE("RowPipeline: Text rows and matrix sources", "[RowPipeline]") {
+    DynamicMatrix matrix = makeMatrix(4, 3);
+    std::string filename = "test_pipeline.txt";
+
+    CHECK(writeTextRows(matrixRows(matrix), filename) == 4);
+    CHECK(collectRows(readTextRows(filename, 3)) == matrix);
+
+    std::ofstream malformed(filename);
+    malformed << "1 2 3 4 5 6 7 8 9\n1 2 x\n";
+    malformed.close();
+    CHECK_THROWS_AS(collectRows(readTextRows(filename, 3)), const std::runtime_error&);
+
+    std::remove(filename.c_str());
+}
+
+TEST_CASE("RowPipeline: Errors reach the sink", "[RowPipeline]") {
+    CHECK_THROWS_AS(collectRows(readBinaryRows("non_existent_file.bin")), const std::runtime_error&);
+    CHECK_THROWS_AS(collectRows(runOnThread(readBinaryRows("non_existent_file.bin"))),
+                    const std::runtime_error&);
+    CHECK(collectRows(matrixRows(DynamicMatrix())).getRows() == 0);
+}